@@ -0,0 +1,158 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "base/config_reload.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <QTemporaryDir>
+#include <QTest>
+
+using theseus_ship::base::config_reload;
+
+class config_reload_test : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void changed_group();
+    void unchanged_group();
+    void coalesced_notifications();
+    void prefix_group();
+    void emptied_group();
+
+private:
+    /// Writes @p value to @p key of @p group in the file behind the shared config.
+    void write(QString const& group, QString const& key, QString const& value);
+
+    QTemporaryDir dir;
+    QString path;
+    KSharedConfigPtr config;
+};
+
+void config_reload_test::init()
+{
+    QVERIFY(dir.isValid());
+
+    // Shared configs are cached by name as long as they are referenced.
+    config.reset();
+    path = dir.filePath(QStringLiteral("kwinrc"));
+    QFile::remove(path);
+
+    write(QStringLiteral("Foo"), QStringLiteral("Key"), QStringLiteral("1"));
+    write(QStringLiteral("Bar"), QStringLiteral("Key"), QStringLiteral("1"));
+    config = KSharedConfig::openConfig(path, KConfig::SimpleConfig);
+}
+
+void config_reload_test::write(QString const& group, QString const& key, QString const& value)
+{
+    KConfig file(path, KConfig::SimpleConfig);
+    file.group(group).writeEntry(key, value);
+    QVERIFY(file.sync());
+}
+
+void config_reload_test::changed_group()
+{
+    config_reload reload(config);
+
+    int foo{0};
+    int bar{0};
+    reload.add(QStringLiteral("Foo"), [&] { foo++; });
+    reload.add(QStringLiteral("Bar"), [&] { bar++; });
+
+    write(QStringLiteral("Foo"), QStringLiteral("Key"), QStringLiteral("2"));
+    reload.handle_groups({QStringLiteral("Foo")});
+
+    QTRY_COMPARE(foo, 1);
+    QCOMPARE(bar, 0);
+    QCOMPARE(config->group(QStringLiteral("Foo")).readEntry("Key"), QStringLiteral("2"));
+}
+
+void config_reload_test::unchanged_group()
+{
+    config_reload reload(config);
+
+    int foo{0};
+    int bar{0};
+    reload.add(QStringLiteral("Foo"), [&] { foo++; });
+    reload.add(QStringLiteral("Bar"), [&] { bar++; });
+
+    // A KCM names all groups of its settings, also the ones that were saved unchanged.
+    write(QStringLiteral("Foo"), QStringLiteral("Key"), QStringLiteral("2"));
+    reload.handle_groups({QStringLiteral("Foo"), QStringLiteral("Bar")});
+
+    QTRY_COMPARE(foo, 1);
+    QTest::qWait(100);
+    QCOMPARE(bar, 0);
+
+    // Saving again without changes does not call the handler anew.
+    reload.handle_groups({QStringLiteral("Foo")});
+    QTest::qWait(100);
+    QCOMPARE(foo, 1);
+}
+
+void config_reload_test::coalesced_notifications()
+{
+    config_reload reload(config);
+
+    int calls{0};
+    auto handler = [&] { calls++; };
+    reload.add(QStringLiteral("Foo"), handler);
+    reload.add(QStringLiteral("Bar"), handler);
+
+    write(QStringLiteral("Foo"), QStringLiteral("Key"), QStringLiteral("2"));
+    reload.handle_groups({QStringLiteral("Foo")});
+    write(QStringLiteral("Foo"), QStringLiteral("Key"), QStringLiteral("3"));
+    reload.handle_groups({QStringLiteral("Foo")});
+
+    QTRY_COMPARE(calls, 1);
+    QTest::qWait(100);
+    QCOMPARE(calls, 1);
+    QCOMPARE(config->group(QStringLiteral("Foo")).readEntry("Key"), QStringLiteral("3"));
+}
+
+void config_reload_test::prefix_group()
+{
+    config_reload reload(config);
+
+    int calls{0};
+    reload.add(QStringLiteral("Effect-"), [&] { calls++; }, true);
+
+    write(QStringLiteral("Effect-foo"), QStringLiteral("Key"), QStringLiteral("1"));
+    write(QStringLiteral("Effect-bar"), QStringLiteral("Key"), QStringLiteral("1"));
+    reload.handle_groups({QStringLiteral("Effect-foo"), QStringLiteral("Effect-bar")});
+
+    // The handler is shared by both groups and called once.
+    QTRY_COMPARE(calls, 1);
+    QTest::qWait(100);
+    QCOMPARE(calls, 1);
+}
+
+void config_reload_test::emptied_group()
+{
+    config_reload reload(config);
+
+    int foo{0};
+    reload.add(QStringLiteral("Foo"), [&] { foo++; });
+
+    {
+        KConfig file(path, KConfig::SimpleConfig);
+        file.group(QStringLiteral("Foo")).deleteEntry("Key");
+        QVERIFY(file.sync());
+    }
+    reload.handle_groups({QStringLiteral("Foo")});
+
+    QTRY_COMPARE(foo, 1);
+
+    // A group named without ever having entries is not a change.
+    reload.handle_groups({QStringLiteral("Baz")});
+    QTest::qWait(100);
+    QCOMPARE(foo, 1);
+}
+
+QTEST_GUILESS_MAIN(config_reload_test)
+#include "config_reload_test.moc"
@@ -0,0 +1,154 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "benchmark/input_recording.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace theseus_ship::benchmark;
+
+class input_recording_test : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void round_trip();
+    void clamped_time();
+    void truncated();
+    void foreign_file();
+};
+
+void input_recording_test::round_trip()
+{
+    QTemporaryDir dir;
+    auto const path = dir.filePath(QStringLiteral("input"));
+
+    std::vector<input_record> const written{
+        {.time = 0,
+         .type = record_type::device_added,
+         .device = 0,
+         .code = static_cast<uint16_t>(device_kind::pointer),
+         .state = 0,
+         .x = 0,
+         .y = 0,
+         .unaccel_x = 0,
+         .unaccel_y = 0},
+        {.time = 0,
+         .type = record_type::pointer_motion,
+         .device = 0,
+         .code = 0,
+         .state = 0,
+         .x = 1.5,
+         .y = -2,
+         .unaccel_x = 0.75,
+         .unaccel_y = -1},
+        {.time = 0,
+         .type = record_type::pointer_button,
+         .device = 0,
+         .code = 0x110,
+         .state = 1,
+         .x = 0,
+         .y = 0,
+         .unaccel_x = 0,
+         .unaccel_y = 0},
+    };
+
+    // More records than fit into a batch, so the writer flushes in between.
+    {
+        recording_writer writer(path);
+        QVERIFY(writer.is_open());
+
+        uint64_t time{1000000};
+        for (int i = 0; i < 100; i++) {
+            for (auto const& record : written) {
+                writer.add(time, record);
+                time += 10;
+            }
+        }
+    }
+
+    auto const read = read_recording(path);
+    QVERIFY(read);
+    QCOMPARE(read->size(), written.size() * 100);
+
+    for (size_t i = 0; i < read->size(); i++) {
+        auto const& record = read->at(i);
+        auto const& expected = written.at(i % written.size());
+
+        // Times are relative to the first record.
+        QCOMPARE(record.time, i * 10);
+        QVERIFY(record.type == expected.type);
+        QCOMPARE(record.device, expected.device);
+        QCOMPARE(record.code, expected.code);
+        QCOMPARE(record.state, expected.state);
+        QCOMPARE(record.x, expected.x);
+        QCOMPARE(record.y, expected.y);
+        QCOMPARE(record.unaccel_x, expected.unaccel_x);
+        QCOMPARE(record.unaccel_y, expected.unaccel_y);
+    }
+}
+
+void input_recording_test::clamped_time()
+{
+    QTemporaryDir dir;
+    auto const path = dir.filePath(QStringLiteral("input"));
+
+    // Records taken from the current time come before queued events with earlier timestamps.
+    {
+        recording_writer writer(path);
+        writer.add(1000, {.type = record_type::device_added});
+        writer.add(500, {.type = record_type::pointer_motion});
+        writer.add(2000, {.type = record_type::pointer_motion});
+        writer.add(1500, {.type = record_type::pointer_frame});
+        writer.add(3000, {.type = record_type::pointer_motion});
+    }
+
+    auto const read = read_recording(path);
+    QVERIFY(read);
+    QCOMPARE(read->size(), size_t(5));
+
+    std::vector<uint64_t> const expected{0, 0, 1000, 1000, 2000};
+    for (size_t i = 0; i < read->size(); i++) {
+        QCOMPARE(read->at(i).time, expected.at(i));
+    }
+}
+
+void input_recording_test::truncated()
+{
+    QTemporaryDir dir;
+    auto const path = dir.filePath(QStringLiteral("input"));
+
+    {
+        recording_writer writer(path);
+        writer.add(0, {.type = record_type::key, .code = 30, .state = 1});
+        writer.add(10, {.type = record_type::key, .code = 30, .state = 0});
+    }
+
+    // A crash while writing leaves an incomplete record at the end, which is dropped.
+    QFile file(path);
+    QVERIFY(file.resize(file.size() - 1));
+
+    auto const read = read_recording(path);
+    QVERIFY(read);
+    QCOMPARE(read->size(), size_t(1));
+    QCOMPARE(read->front().state, uint32_t(1));
+}
+
+void input_recording_test::foreign_file()
+{
+    QTemporaryDir dir;
+    auto const path = dir.filePath(QStringLiteral("input"));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(64, 'x'));
+    file.close();
+
+    QVERIFY(!read_recording(path));
+}
+
+QTEST_GUILESS_MAIN(input_recording_test)
+#include "input_recording_test.moc"
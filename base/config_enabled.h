@@ -0,0 +1,28 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <memory>
+#include <utility>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Creates a @p T from @p args when the Enabled entry of @p config is set and returns null
+ * otherwise. Facilities for debugging and tuning are off by default and created through this.
+ */
+template<typename T, typename... Args>
+std::unique_ptr<T> create_if_enabled(KConfigGroup const& config, Args&&... args)
+{
+    if (!config.readEntry("Enabled", false)) {
+        return {};
+    }
+    return std::make_unique<T>(std::forward<Args>(args)...);
+}
+
+}
@@ -0,0 +1,124 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "config_reload.h"
+
+#include <KConfigGroup>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+// KCMs save multiple modules one after the other, each sending a notification.
+constexpr std::chrono::milliseconds coalesce_interval{50};
+
+}
+
+config_reload::config_reload(KSharedConfigPtr config)
+    : config{std::move(config)}
+{
+    update_contents();
+
+    timer.setSingleShot(true);
+    timer.setInterval(coalesce_interval);
+    QObject::connect(&timer, &QTimer::timeout, this, [this] { reload(); });
+
+    QDBusConnection::sessionBus().connect(QString(),
+                                          QStringLiteral("/KWin"),
+                                          QStringLiteral("org.kde.KWin"),
+                                          QStringLiteral("reloadConfigGroups"),
+                                          this,
+                                          SLOT(handle_groups(QStringList)));
+}
+
+void config_reload::add(QString const& group, std::function<void()> handler, bool prefix)
+{
+    (prefix ? prefix_handlers : handlers)[group] = std::move(handler);
+}
+
+void config_reload::handle_groups(QStringList const& groups)
+{
+    pending.insert(groups.cbegin(), groups.cend());
+    timer.start();
+}
+
+std::function<void()> const* config_reload::find_handler(QString const& group) const
+{
+    if (auto it = handlers.find(group); it != handlers.end()) {
+        return &it->second;
+    }
+    for (auto const& [prefix, handler] : prefix_handlers) {
+        if (group.startsWith(prefix)) {
+            return &handler;
+        }
+    }
+    return nullptr;
+}
+
+void config_reload::update_contents()
+{
+    contents.clear();
+    for (auto const& group : config->groupList()) {
+        contents[group] = config->group(group).entryMap();
+    }
+}
+
+void config_reload::reload()
+{
+    config->reparseConfiguration();
+
+    std::vector<std::function<void()> const*> changed_handlers;
+    QStringList unhandled;
+
+    for (auto const& group : pending) {
+        auto entries = config->group(group).entryMap();
+        // Groups without entries are the same as missing ones.
+        auto const it = contents.find(group);
+        if (it == contents.end() ? entries.isEmpty() : it->second == entries) {
+            continue;
+        }
+        contents[group] = std::move(entries);
+
+        auto handler = find_handler(group);
+        if (!handler) {
+            unhandled << group;
+            continue;
+        }
+        if (std::find(changed_handlers.cbegin(), changed_handlers.cend(), handler)
+            == changed_handlers.cend()) {
+            changed_handlers.push_back(handler);
+        }
+    }
+    pending.clear();
+
+    for (auto handler : changed_handlers) {
+        (*handler)();
+    }
+
+    if (unhandled.isEmpty()) {
+        return;
+    }
+
+    // Subsystems of the platforms only support reloading everything. The call goes to our own
+    // connection, other instances handle the notification themselves. All groups are read anew
+    // by it, so their contents are taken over as well.
+    qDebug() << "Full config reload for changed groups" << unhandled;
+    update_contents();
+
+    auto bus = QDBusConnection::sessionBus();
+    bus.asyncCall(QDBusMessage::createMethodCall(bus.baseService(),
+                                                 QStringLiteral("/KWin"),
+                                                 QStringLiteral("org.kde.KWin"),
+                                                 QStringLiteral("reconfigure")));
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KSharedConfig>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <set>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Handles the reloadConfigGroups signal on org.kde.KWin, which names the groups of kwinrc that
+ * were saved. Only groups whose content changed since the last reload are considered. Their
+ * handlers are called, and groups without handler cause a full reconfigure. Only the groups of
+ * this tree have handlers. All groups read by the platforms, like TabBox, Windows,
+ * ElectricBorders or Desktops, are reloaded by a full reconfigure. Notifications arriving in
+ * short succession are handled together.
+ */
+class config_reload : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit config_reload(KSharedConfigPtr config);
+
+    /// Handles changes of @p group, or of all groups starting with it when @p prefix is set.
+    void add(QString const& group, std::function<void()> handler, bool prefix = false);
+
+public Q_SLOTS:
+    void handle_groups(QStringList const& groups);
+
+private:
+    void reload();
+    void update_contents();
+    std::function<void()> const* find_handler(QString const& group) const;
+
+    KSharedConfigPtr config;
+    std::map<QString, QMap<QString, QString>> contents;
+    std::map<QString, std::function<void()>> handlers;
+    std::map<QString, std::function<void()>> prefix_handlers;
+    std::set<QString> pending;
+    QTimer timer;
+};
+
+}
@@ -0,0 +1,95 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "idle_housekeeping.h"
+#include "config_enabled.h"
+#include "protocol_logger.h"
+
+#include <QGuiApplication>
+#include <QPixmapCache>
+#include <QQuickWindow>
+#include <algorithm>
+#include <malloc.h>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+constexpr std::chrono::seconds default_timeout{30};
+
+}
+
+idle_housekeeping::idle_housekeeping(protocol_logger& logger, std::chrono::milliseconds timeout)
+    : timeout{timeout}
+    , last_activity{std::chrono::steady_clock::now()}
+    , logger{logger}
+{
+    auto activity = [this](auto const& /*message*/) { handle_activity(); };
+    logger.add(this, protocol_direction::request, "wl_surface", "commit", activity);
+
+    // Input is only forwarded to clients through these interfaces.
+    for (auto interface : {"wl_pointer", "wl_keyboard", "wl_touch"}) {
+        logger.add(this, protocol_direction::event, interface, nullptr, activity);
+    }
+
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, [this] { check(); });
+    timer.start(timeout);
+}
+
+idle_housekeeping::~idle_housekeeping()
+{
+    logger.remove(this);
+}
+
+void idle_housekeeping::handle_activity()
+{
+    // Called for many protocol messages. Restarting the timer each time would be too expensive.
+    last_activity = std::chrono::steady_clock::now();
+    if (!timer.isActive()) {
+        timer.start(timeout);
+    }
+}
+
+void idle_housekeeping::check()
+{
+    auto const idle = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - last_activity);
+
+    if (idle < timeout) {
+        timer.start(timeout - idle);
+        return;
+    }
+
+    run_housekeeping();
+}
+
+void run_housekeeping()
+{
+    // Scenes of hidden Qt Quick windows, for example of effects and the tabbox, are rebuilt
+    // when shown again. The component caches of the QML engines are kept, since compiling the
+    // components again would delay showing them.
+    for (auto window : QGuiApplication::allWindows()) {
+        auto quick_window = qobject_cast<QQuickWindow*>(window);
+        if (quick_window && !quick_window->isVisible()) {
+            quick_window->releaseResources();
+        }
+    }
+
+    QPixmapCache::clear();
+    malloc_trim(0);
+}
+
+std::unique_ptr<idle_housekeeping> create_idle_housekeeping(protocol_logger& logger,
+                                                            KConfigGroup const& config)
+{
+    auto const timeout = std::chrono::seconds(
+        std::max(1, config.readEntry("IdleTimeout", static_cast<int>(default_timeout.count()))));
+    return create_if_enabled<idle_housekeeping>(config, logger, timeout);
+}
+
+}
@@ -0,0 +1,50 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <QTimer>
+#include <chrono>
+#include <memory>
+
+namespace theseus_ship::base
+{
+
+class protocol_logger;
+
+/**
+ * Returns freed memory and caches to the system once the session is idle. The session counts as
+ * idle when for the timeout no input event was sent to a client and no client committed a
+ * surface. Afterwards the housekeeping runs again only after the next activity.
+ */
+class idle_housekeeping
+{
+public:
+    idle_housekeeping(protocol_logger& logger, std::chrono::milliseconds timeout);
+    ~idle_housekeeping();
+
+    idle_housekeeping(idle_housekeeping const&) = delete;
+    idle_housekeeping& operator=(idle_housekeeping const&) = delete;
+
+    void handle_activity();
+
+private:
+    void check();
+
+    std::chrono::milliseconds const timeout;
+    std::chrono::steady_clock::time_point last_activity;
+    protocol_logger& logger;
+    QTimer timer;
+};
+
+/// Releases the scenes of hidden Qt Quick windows, clears QPixmapCache and trims the heap.
+void run_housekeeping();
+
+/// Returns null if not enabled in the Housekeeping group of kwinrc.
+std::unique_ptr<idle_housekeeping> create_idle_housekeeping(protocol_logger& logger,
+                                                            KConfigGroup const& config);
+
+}
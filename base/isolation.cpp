@@ -0,0 +1,161 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "isolation.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/ioprio.h>
+#include <sys/xattr.h>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+QString const cgroup_root = QStringLiteral("/sys/fs/cgroup");
+
+/// Whether systemd delegated the cgroup at @p path, which marks it with an extended attribute.
+bool is_delegated(QString const& path)
+{
+    auto const encoded = QFile::encodeName(path);
+
+    for (auto name : {"user.delegate", "trusted.delegate"}) {
+        char value{0};
+        if (getxattr(encoded.constData(), name, &value, 1) == 1 && value == '1') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Whether the cgroup at @p path or one of its ancestors is delegated.
+bool in_delegated_subtree(QString const& path)
+{
+    for (auto current = path; current.startsWith(cgroup_root + QLatin1Char('/'));
+         current = QDir::cleanPath(current + QStringLiteral("/.."))) {
+        if (is_delegated(current)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<int> read_int(QString const& value, char const* name)
+{
+    if (value.isEmpty()) {
+        return std::nullopt;
+    }
+
+    bool ok{false};
+    auto const number = value.toInt(&ok);
+    if (!ok) {
+        qWarning() << "Invalid" << name << value;
+        return std::nullopt;
+    }
+    return number;
+}
+
+}
+
+std::optional<int> parse_io_priority(QString const& value)
+{
+    if (value.isEmpty()) {
+        return std::nullopt;
+    }
+    if (value == QStringLiteral("idle")) {
+        return IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0);
+    }
+
+    auto level = value;
+    if (level.startsWith(QStringLiteral("be:"))) {
+        level = level.mid(3);
+    }
+
+    bool ok{false};
+    auto const number = level.toInt(&ok);
+    if (!ok || number < 0 || number > 7) {
+        qWarning() << "Invalid I/O priority" << value;
+        return std::nullopt;
+    }
+    return IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE, number);
+}
+
+int open_cgroup_procs(QString const& cgroup)
+{
+    if (!cgroup.startsWith(QLatin1Char('/'))) {
+        qWarning() << "Cgroup" << cgroup << "is not an absolute path";
+        return -1;
+    }
+
+    auto const path = QDir::cleanPath(cgroup_root + cgroup);
+    if (!path.startsWith(cgroup_root + QLatin1Char('/'))) {
+        qWarning() << "Cgroup" << cgroup << "is outside of the cgroup hierarchy";
+        return -1;
+    }
+
+    // Outside of a delegated subtree systemd is the only one allowed to change the hierarchy.
+    if (!in_delegated_subtree(path)) {
+        qWarning() << "Cgroup" << cgroup << "is not in a subtree delegated by systemd";
+        return -1;
+    }
+
+    if (!QDir().mkpath(path)) {
+        qWarning() << "Failed to create cgroup" << path;
+        return -1;
+    }
+
+    auto const procs = QFile::encodeName(path + QStringLiteral("/cgroup.procs"));
+    auto const fd = open(procs.constData(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "Failed to open" << procs << strerror(errno);
+    }
+    return fd;
+}
+
+void isolation_options::add_to(QCommandLineParser& parser) const
+{
+    parser.addOption(nice);
+    parser.addOption(io_priority);
+    parser.addOption(oom_score_adj);
+    parser.addOption(cgroup);
+}
+
+isolation_settings isolation_options::read(QCommandLineParser const& parser,
+                                           KConfigGroup const& config) const
+{
+    auto value = [&](QCommandLineOption const& option, char const* key) {
+        return parser.isSet(option) ? parser.value(option) : config.readEntry(key, QString());
+    };
+
+    isolation_settings settings;
+
+    // The launcher has the privileges of the compositor until the application is executed. A
+    // negative value would give the application a priority its user could not set.
+    settings.nice = read_int(value(nice, "Nice"), "nice value");
+    if (settings.nice) {
+        settings.nice = std::clamp(*settings.nice, 0, 19);
+    }
+
+    settings.io_priority = parse_io_priority(value(io_priority, "IoPriority"));
+
+    // Lowering the score below the one of the compositor needs privileges.
+    settings.oom_score_adj = read_int(value(oom_score_adj, "OomScoreAdjust"), "OOM score");
+    if (settings.oom_score_adj) {
+        settings.oom_score_adj = std::clamp(*settings.oom_score_adj, 0, 1000);
+    }
+
+    settings.cgroup = value(cgroup, "Cgroup");
+
+    return settings;
+}
+
+}
@@ -0,0 +1,73 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <KLocalizedString>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <optional>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Limits applied to processes the compositor launches, so they can not starve it of CPU time or
+ * I/O bandwidth and are killed before it on memory pressure.
+ */
+struct isolation_settings {
+    std::optional<int> nice;
+    // The class and level as expected by ioprio_set().
+    std::optional<int> io_priority;
+    std::optional<int> oom_score_adj;
+
+    // An absolute cgroup v2 path from the root of the cgroup hierarchy.
+    QString cgroup;
+};
+
+/// Parses "idle" or a best-effort level from 0 to 7, optionally prefixed with "be:".
+std::optional<int> parse_io_priority(QString const& value);
+
+/**
+ * Opens the cgroup.procs file of @p cgroup for writing. The cgroup must be in a subtree systemd
+ * delegated, for example with Delegate=yes on a unit, and is created inside of it if needed.
+ * Returns -1 on failure.
+ */
+int open_cgroup_procs(QString const& cgroup);
+
+/**
+ * Command line options for the isolation settings. They take precedence over the ones in the
+ * Launcher group of kwinrc.
+ */
+struct isolation_options {
+    QCommandLineOption nice{
+        QStringLiteral("app-nice"),
+        i18n("Nice value of launched applications, from 0 to 19."),
+        QStringLiteral("nice"),
+    };
+    QCommandLineOption io_priority{
+        QStringLiteral("app-ioprio"),
+        i18n("I/O priority of launched applications: \"idle\" or a best-effort level from 0 to "
+             "7."),
+        QStringLiteral("priority"),
+    };
+    QCommandLineOption oom_score_adj{
+        QStringLiteral("app-oom-score-adj"),
+        i18n("OOM score adjustment of launched applications, from 0 to 1000."),
+        QStringLiteral("score"),
+    };
+    QCommandLineOption cgroup{
+        QStringLiteral("app-cgroup"),
+        i18n("Absolute cgroup to place launched applications in. It must be in a subtree "
+             "delegated by systemd."),
+        QStringLiteral("path"),
+    };
+
+    void add_to(QCommandLineParser& parser) const;
+    isolation_settings read(QCommandLineParser const& parser, KConfigGroup const& config) const;
+};
+
+}
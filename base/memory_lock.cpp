@@ -0,0 +1,227 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "memory_lock.h"
+
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <vector>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+// Heap and anonymous mappings of malloc grow with the session.
+constexpr std::chrono::minutes rescan_interval{1};
+
+struct mapping {
+    uintptr_t start;
+    uintptr_t end;
+    bool code;
+    bool locked;
+};
+
+/// Parses the header line of a mapping in smaps. Returns false if it is not worth locking.
+bool parse_mapping(QByteArray const& line, mapping& mapping)
+{
+    // The format is "start-end perms offset dev inode [path]".
+    auto const fields = line.simplified().split(' ');
+    if (fields.size() < 5) {
+        return false;
+    }
+
+    auto const range = fields.at(0).split('-');
+    auto const& perms = fields.at(1);
+    auto const path = fields.size() > 5 ? fields.at(5) : QByteArray();
+
+    if (range.size() != 2 || perms.size() < 4 || perms.at(0) != 'r') {
+        return false;
+    }
+
+    // Shared mappings are client buffers or device memory. They are not ours to lock.
+    if (perms.at(3) != 'p' || path.startsWith("/dev/") || path.startsWith("/memfd:")) {
+        return false;
+    }
+
+    auto const code = perms.at(2) == 'x' && path.startsWith('/');
+    if (!code && perms.at(1) != 'w') {
+        return false;
+    }
+    if (path.startsWith("[v")) {
+        // The vdso, vvar and vsyscall pages.
+        return false;
+    }
+
+    mapping = {
+        .start = range.at(0).toULongLong(nullptr, 16),
+        .end = range.at(1).toULongLong(nullptr, 16),
+        .code = code,
+        .locked = false,
+    };
+    return true;
+}
+
+/// Mappings worth locking, data before code.
+std::vector<mapping> lockable_mappings()
+{
+    std::vector<mapping> mappings;
+
+    QFile file(QStringLiteral("/proc/self/smaps"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return mappings;
+    }
+
+    bool lockable{false};
+
+    for (auto const& line : file.readAll().split('\n')) {
+        auto const colon = line.indexOf(':');
+        auto const space = line.indexOf(' ');
+
+        // Field lines have the colon right after the key, headers have the address range first.
+        if (colon < 0 || (space >= 0 && space < colon)) {
+            mapping mapping;
+            lockable = parse_mapping(line, mapping);
+            if (lockable) {
+                mappings.push_back(mapping);
+            }
+            continue;
+        }
+
+        // Mappings locked by an earlier pass carry the lo flag. Memory mapped since then is in
+        // mappings of its own, since mappings with different flags are not merged.
+        if (lockable && line.left(colon) == "VmFlags") {
+            mappings.back().locked = line.mid(colon + 1).simplified().split(' ').contains("lo");
+        }
+    }
+
+    std::stable_partition(
+        mappings.begin(), mappings.end(), [](auto const& mapping) { return !mapping.code; });
+    return mappings;
+}
+
+/// Raises the soft limit to the hard one and returns it.
+int64_t memlock_limit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) != 0) {
+        return 0;
+    }
+
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_MEMLOCK, &limit);
+
+    if (limit.rlim_cur == RLIM_INFINITY) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    return static_cast<int64_t>(limit.rlim_cur);
+}
+
+}
+
+memory_lock::memory_lock(memory_lock_settings const& settings)
+    : settings{settings}
+{
+    QObject::connect(&rescan_timer, &QTimer::timeout, [this] { lock(); });
+    rescan_timer.start(rescan_interval);
+}
+
+memory_lock_result memory_lock::lock()
+{
+    memory_lock_result result;
+
+    auto mappings = lockable_mappings();
+    auto const limit = std::min(settings.limit, memlock_limit());
+
+    for (auto const& mapping : mappings) {
+        if (mapping.locked) {
+            auto const size = static_cast<int64_t>(mapping.end - mapping.start);
+            (mapping.code ? result.code : result.data) += size;
+        }
+    }
+
+    // Code locked by an earlier pass is unlocked again when new data needs its room.
+    auto make_room = [&](int64_t size) {
+        for (auto it = mappings.rbegin();
+             it != mappings.rend() && it->code && result.data + result.code + size > limit;
+             ++it) {
+            if (!it->locked) {
+                continue;
+            }
+            auto const locked = static_cast<int64_t>(it->end - it->start);
+            if (munlock(reinterpret_cast<void*>(it->start), locked) == 0) {
+                it->locked = false;
+                result.code -= locked;
+            }
+        }
+    };
+
+    bool warned{false};
+
+    // Mappings are sorted data first. Data is only accounted against data, code against both.
+    for (auto& mapping : mappings) {
+        if (mapping.locked) {
+            continue;
+        }
+
+        auto const size = static_cast<int64_t>(mapping.end - mapping.start);
+        auto const address = reinterpret_cast<void*>(mapping.start);
+
+        if (size > limit - result.data - (mapping.code ? result.code : 0)) {
+            result.skipped += size;
+            continue;
+        }
+        if (!mapping.code) {
+            make_room(size);
+        }
+
+        // Data pages that are not resident yet are locked once first touched.
+        auto const ret = mapping.code ? mlock(address, size) : mlock2(address, size, MLOCK_ONFAULT);
+        if (ret != 0) {
+            if (!warned) {
+                qWarning() << "Failed to lock memory:" << strerror(errno);
+                warned = true;
+            }
+            result.skipped += size;
+            continue;
+        }
+
+        mapping.locked = true;
+        (mapping.code ? result.code : result.data) += size;
+    }
+
+    return result;
+}
+
+void memory_lock_options::add_to(QCommandLineParser& parser) const
+{
+    parser.addOption(enabled);
+    parser.addOption(limit);
+}
+
+memory_lock_settings memory_lock_options::read(QCommandLineParser const& parser,
+                                               KConfigGroup const& config) const
+{
+    memory_lock_settings settings;
+
+    settings.enabled = parser.isSet(enabled) || config.readEntry("Enabled", false);
+
+    auto const limit_mib = parser.isSet(limit)
+        ? parser.value(limit).toInt()
+        : config.readEntry("Limit", static_cast<int>(settings.limit / 1024 / 1024));
+    settings.limit = std::max(0, limit_mib) * int64_t{1024 * 1024};
+
+    return settings;
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <KLocalizedString>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <cstdint>
+
+namespace theseus_ship::base
+{
+
+struct memory_lock_settings {
+    bool enabled{false};
+    // At most this many bytes are locked. It is further limited by RLIMIT_MEMLOCK.
+    int64_t limit{256 * 1024 * 1024};
+};
+
+struct memory_lock_result {
+    int64_t code{0};
+    int64_t data{0};
+    // Mappings that did not fit into the limit anymore.
+    int64_t skipped{0};
+};
+
+/**
+ * Locks the private data of the compositor and then the code of it and its libraries in memory,
+ * as long as the limit allows. Data comes first, since the heap and stacks are touched in every
+ * frame while much of the mapped code rarely runs. Data is only locked where it is resident
+ * already or once it becomes resident, so the lock does not increase memory usage. Code is paged
+ * in right away.
+ *
+ * Heap and other data mapped later are locked on a regular rescan. It is only limited by the data
+ * locked so far, locked code is unlocked again to make room for it. Mappings that fail to lock
+ * are skipped and tried again on the next rescan.
+ */
+class memory_lock
+{
+public:
+    explicit memory_lock(memory_lock_settings const& settings);
+
+    memory_lock(memory_lock const&) = delete;
+    memory_lock& operator=(memory_lock const&) = delete;
+
+    /// Locks what is not locked yet. Returns the memory locked in total.
+    memory_lock_result lock();
+
+private:
+    memory_lock_settings const settings;
+    QTimer rescan_timer;
+};
+
+/**
+ * Command line options for locking memory. They take precedence over the ones in the MemoryLock
+ * group of kwinrc.
+ */
+struct memory_lock_options {
+    QCommandLineOption enabled{
+        QStringLiteral("mlock"),
+        i18n("Lock the code and data of the compositor in memory once started."),
+    };
+    QCommandLineOption limit{
+        QStringLiteral("mlock-limit"),
+        i18n("Maximum amount of memory to lock in MiB."),
+        QStringLiteral("MiB"),
+    };
+
+    void add_to(QCommandLineParser& parser) const;
+    memory_lock_settings read(QCommandLineParser const& parser, KConfigGroup const& config) const;
+};
+
+}
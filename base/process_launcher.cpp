@@ -0,0 +1,397 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "process_launcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/ioprio.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+constexpr size_t child_stack_size{64 * 1024};
+
+struct child_args {
+    char const* path;
+    char* const* argv;
+    char* const* envp;
+    rlimit nofile_limit;
+    cpu_set_t const* affinity;
+    int nice;
+    int io_priority;
+    char const* oom_score_adj;
+    int cgroup_fd;
+    int stdin_fd;
+    int error{0};
+};
+
+/**
+ * Runs in the child, which shares the memory of the compositor until it calls execve(). Only
+ * async-signal-safe functions may be used here.
+ */
+int child_main(void* data)
+{
+    auto args = static_cast<child_args*>(data);
+
+    // Signal handlers of the compositor must not run in the child. Ignored signals like SIGPIPE
+    // are reset as well, since they would be inherited through execve().
+    struct sigaction action {
+    };
+    action.sa_handler = SIG_DFL;
+    for (int signal = 1; signal < NSIG; signal++) {
+        sigaction(signal, &action, nullptr);
+    }
+
+    // The compositor runs with a bumped limit. Some applications still use select() though.
+    setrlimit(RLIMIT_NOFILE, &args->nofile_limit);
+
+    // The compositor may be pinned to CPUs reserved for it. Its scheduling policy is set with
+    // SCHED_RESET_ON_FORK, so a realtime policy or a negative nice value is already reset.
+    sched_setaffinity(0, sizeof(cpu_set_t), args->affinity);
+
+    // Failures are ignored. The application is better started without isolation than not at all.
+    if (args->cgroup_fd >= 0) {
+        write(args->cgroup_fd, "0", 1);
+    }
+    if (args->oom_score_adj) {
+        auto const fd = open("/proc/self/oom_score_adj", O_WRONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            write(fd, args->oom_score_adj, strlen(args->oom_score_adj));
+            close(fd);
+        }
+    }
+    setpriority(PRIO_PROCESS, 0, args->nice);
+    if (args->io_priority >= 0) {
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, args->io_priority);
+    }
+
+    if (args->stdin_fd >= 0) {
+        dup2(args->stdin_fd, STDIN_FILENO);
+    }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, nullptr);
+
+    execve(args->path, args->argv, args->envp);
+
+    // With CLONE_VFORK the parent only continues after this, so it can read the value safely.
+    args->error = errno;
+    _exit(127);
+}
+
+// Written to by the SIGCHLD handler for children without a pidfd.
+int sigchld_pipe[2]{-1, -1};
+struct sigaction previous_sigchld {
+};
+
+void handle_sigchld(int signal, siginfo_t* info, void* context)
+{
+    auto const saved_errno = errno;
+    char const byte{0};
+    [[maybe_unused]] auto ret = write(sigchld_pipe[1], &byte, 1);
+    errno = saved_errno;
+
+    // Others, like QProcess without pidfds, may rely on their handler too.
+    if (previous_sigchld.sa_flags & SA_SIGINFO) {
+        previous_sigchld.sa_sigaction(signal, info, context);
+    } else if (previous_sigchld.sa_handler != SIG_DFL && previous_sigchld.sa_handler != SIG_IGN) {
+        previous_sigchld.sa_handler(signal);
+    }
+}
+
+/// Installs the SIGCHLD handler on first use. Returns null if that is not possible.
+QSocketNotifier* sigchld_notifier()
+{
+    static std::unique_ptr<QSocketNotifier> notifier;
+    if (notifier) {
+        return notifier.get();
+    }
+
+    if (pipe2(sigchld_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return nullptr;
+    }
+
+    struct sigaction action {
+    };
+    action.sa_sigaction = handle_sigchld;
+    action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, &previous_sigchld);
+
+    notifier = std::make_unique<QSocketNotifier>(sigchld_pipe[0], QSocketNotifier::Read);
+
+    // Connected first, so the pipe is drained before the children check for their exit.
+    QObject::connect(notifier.get(), &QSocketNotifier::activated, [] {
+        char buffer[64];
+        while (read(sigchld_pipe[0], buffer, sizeof(buffer)) > 0) { }
+    });
+    return notifier.get();
+}
+
+pid_t clone_vfork(child_args& args)
+{
+    auto stack = mmap(nullptr,
+                      child_stack_size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK,
+                      -1,
+                      0);
+    if (stack == MAP_FAILED) {
+        args.error = errno;
+        return -1;
+    }
+
+    // No signal handler may run in the child while it shares our memory.
+    sigset_t all;
+    sigset_t old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+
+    auto const pid = clone(child_main,
+                           static_cast<char*>(stack) + child_stack_size,
+                           CLONE_VM | CLONE_VFORK | SIGCHLD,
+                           &args);
+    if (pid < 0) {
+        args.error = errno;
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old, nullptr);
+    munmap(stack, child_stack_size);
+
+    return pid;
+}
+
+}
+
+child_process::child_process(pid_t pid)
+    : pid{pid}
+    , pidfd{static_cast<int>(syscall(SYS_pidfd_open, pid, 0))}
+{
+    if (pidfd >= 0) {
+        fcntl(pidfd, F_SETFD, FD_CLOEXEC);
+        notifier = std::make_unique<QSocketNotifier>(pidfd, QSocketNotifier::Read);
+        QObject::connect(notifier.get(), &QSocketNotifier::activated, [this] { handle_exit(); });
+        watching = true;
+        return;
+    }
+
+    // Kernels before 5.3 have no pidfds.
+    auto const sigchld = sigchld_notifier();
+    if (!sigchld) {
+        qWarning() << "Cannot watch process" << pid << "for its exit:" << strerror(errno);
+        return;
+    }
+    sigchld_connection
+        = QObject::connect(sigchld, &QSocketNotifier::activated, [this] { handle_exit(); });
+    watching = true;
+
+    // The process may have exited before the handler was installed. It is checked from the event
+    // loop, once the callback is set.
+    char const byte{0};
+    [[maybe_unused]] auto ret = write(sigchld_pipe[1], &byte, 1);
+}
+
+child_process::~child_process()
+{
+    QObject::disconnect(sigchld_connection);
+    if (pidfd >= 0) {
+        close(pidfd);
+    }
+}
+
+bool child_process::running() const
+{
+    return watching;
+}
+
+void child_process::stop_watching()
+{
+    watching = false;
+    if (notifier) {
+        notifier->setEnabled(false);
+    }
+    QObject::disconnect(sigchld_connection);
+}
+
+void child_process::terminate(std::chrono::milliseconds timeout)
+{
+    if (!running()) {
+        return;
+    }
+
+    stop_watching();
+    kill(pid, SIGTERM);
+
+    if (pidfd >= 0) {
+        pollfd pfd{.fd = pidfd, .events = POLLIN, .revents = 0};
+        if (poll(&pfd, 1, timeout.count()) == 1) {
+            waitpid(pid, nullptr, 0);
+        }
+        return;
+    }
+
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while (waitpid(pid, nullptr, WNOHANG) == 0 && std::chrono::steady_clock::now() < deadline) {
+        usleep(10000);
+    }
+}
+
+void child_process::handle_exit()
+{
+    int status{0};
+    pid_t result;
+    do {
+        result = waitpid(pid, &status, WNOHANG);
+    } while (result < 0 && errno == EINTR);
+
+    // Still running. SIGCHLD is also raised for other children.
+    if (result == 0) {
+        return;
+    }
+
+    stop_watching();
+    if (!exited) {
+        return;
+    }
+    if (result != pid) {
+        // Reaped by someone else, so the status is lost. The process is gone nevertheless.
+        qWarning() << "Failed to get the exit status of process" << pid << strerror(errno);
+        exited(-1, false);
+        return;
+    }
+    if (WIFSIGNALED(status)) {
+        exited(WTERMSIG(status), true);
+        return;
+    }
+    exited(WEXITSTATUS(status), false);
+}
+
+process_launcher::process_launcher(QProcessEnvironment const& environment,
+                                   rlimit nofile_limit,
+                                   cpu_set_t const& affinity,
+                                   int nice,
+                                   isolation_settings const& isolation)
+    : search_paths{environment.value(QStringLiteral("PATH")).split(QLatin1Char(':'),
+                                                                     Qt::SkipEmptyParts)}
+    , nofile_limit{nofile_limit}
+    , affinity{affinity}
+    , nice{isolation.nice.value_or(nice)}
+    , io_priority{isolation.io_priority}
+{
+    if (isolation.oom_score_adj) {
+        oom_score_adj = std::to_string(*isolation.oom_score_adj);
+    }
+    if (!isolation.cgroup.isEmpty()) {
+        cgroup_fd = open_cgroup_procs(isolation.cgroup);
+    }
+
+    null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    for (auto const& entry : environment.toStringList()) {
+        this->environment.push_back(entry.toStdString());
+    }
+    for (auto& entry : this->environment) {
+        envp.push_back(entry.data());
+    }
+    envp.push_back(nullptr);
+}
+
+process_launcher::~process_launcher()
+{
+    if (cgroup_fd >= 0) {
+        close(cgroup_fd);
+    }
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+}
+
+QString process_launcher::find_executable(QString const& program) const
+{
+    if (program.contains(QLatin1Char('/'))) {
+        return QFileInfo(program).isExecutable() ? program : QString();
+    }
+    return QStandardPaths::findExecutable(program, search_paths);
+}
+
+launch_result process_launcher::spawn(QStringList const& command) const
+{
+    launch_result result{.program = command.value(0)};
+
+    auto const path = find_executable(result.program).toLocal8Bit();
+    if (path.isEmpty()) {
+        result.error = ENOENT;
+        return result;
+    }
+
+    // Everything the child needs is prepared up front, so it does not have to allocate.
+    std::vector<QByteArray> arguments;
+    for (auto const& arg : command) {
+        arguments.push_back(arg.toLocal8Bit());
+    }
+    std::vector<char*> argv;
+    for (auto& arg : arguments) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    child_args args{
+        .path = path.constData(),
+        .argv = argv.data(),
+        .envp = envp.data(),
+        .nofile_limit = nofile_limit,
+        .affinity = &affinity,
+        .nice = nice,
+        .io_priority = io_priority.value_or(-1),
+        .oom_score_adj = oom_score_adj.empty() ? nullptr : oom_score_adj.c_str(),
+        .cgroup_fd = cgroup_fd,
+        .stdin_fd = null_fd,
+    };
+
+    auto const begin = std::chrono::steady_clock::now();
+    result.pid = clone_vfork(args);
+    result.latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin);
+
+    if (result.pid > 0 && args.error) {
+        // The child exited right away since execve() failed.
+        waitpid(result.pid, nullptr, 0);
+        result.pid = -1;
+    }
+
+    result.error = args.error;
+    return result;
+}
+
+std::vector<launch_result> process_launcher::spawn_all(
+    std::vector<QStringList> const& commands) const
+{
+    // A spawn takes only microseconds, since the parent is suspended just until the child
+    // executed the new program. Threads would cost more than they could save.
+    std::vector<launch_result> results;
+    for (auto const& command : commands) {
+        results.push_back(spawn(command));
+    }
+    return results;
+}
+
+}
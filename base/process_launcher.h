@@ -0,0 +1,105 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "isolation.h"
+
+#include <QProcessEnvironment>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <sched.h>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+
+namespace theseus_ship::base
+{
+
+struct launch_result {
+    QString program;
+    pid_t pid{-1};
+    // The errno value in case the process could not be started.
+    int error{0};
+    // Time until the new program image was executed.
+    std::chrono::microseconds latency{0};
+};
+
+/**
+ * A child process started by the launcher. Its exit is noticed through a pidfd, or through
+ * SIGCHLD on kernels without pidfds, and the process is reaped then.
+ */
+class child_process
+{
+public:
+    explicit child_process(pid_t pid);
+    ~child_process();
+
+    /// Sends SIGTERM and waits at most @p timeout for the process to exit.
+    void terminate(std::chrono::milliseconds timeout);
+
+    bool running() const;
+
+    pid_t const pid;
+
+    // Called with the exit code, or with the signal number when the process crashed.
+    std::function<void(int code, bool crashed)> exited;
+
+private:
+    void handle_exit();
+    void stop_watching();
+
+    int pidfd{-1};
+    std::unique_ptr<QSocketNotifier> notifier;
+    QMetaObject::Connection sigchld_connection;
+    bool watching{false};
+};
+
+/**
+ * Starts processes directly through clone(CLONE_VM | CLONE_VFORK) and execve(). In comparison to
+ * QProcess this neither copies the page tables of the compositor nor runs fork handlers. The
+ * original RLIMIT_NOFILE limit, CPU affinity, nice value, signal dispositions and signal mask are
+ * restored in the child. Afterwards the isolation settings are applied to it.
+ */
+class process_launcher
+{
+public:
+    process_launcher(QProcessEnvironment const& environment,
+                     rlimit nofile_limit,
+                     cpu_set_t const& affinity,
+                     int nice,
+                     isolation_settings const& isolation);
+    ~process_launcher();
+
+    process_launcher(process_launcher const&) = delete;
+    process_launcher& operator=(process_launcher const&) = delete;
+
+    launch_result spawn(QStringList const& command) const;
+
+    /// Starts all commands one after the other. Results are in the order of @p commands.
+    std::vector<launch_result> spawn_all(std::vector<QStringList> const& commands) const;
+
+private:
+    QString find_executable(QString const& program) const;
+
+    std::vector<std::string> environment;
+    std::vector<char*> envp;
+    QStringList search_paths;
+    rlimit nofile_limit;
+    cpu_set_t affinity;
+
+    int nice;
+    std::optional<int> io_priority;
+    std::string oom_score_adj;
+    int cgroup_fd{-1};
+    // Standard input of the launched processes.
+    int null_fd{-1};
+};
+
+}
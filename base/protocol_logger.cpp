@@ -0,0 +1,93 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "protocol_logger.h"
+
+#include <string_view>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+void log_message(void* data,
+                 wl_protocol_logger_type direction,
+                 wl_protocol_logger_message const* message)
+{
+    static_cast<protocol_logger*>(data)->handle(direction == WL_PROTOCOL_LOGGER_REQUEST
+                                                    ? protocol_direction::request
+                                                    : protocol_direction::event,
+                                                *message);
+}
+
+}
+
+protocol_logger::protocol_logger(wl_display* display)
+    : display{display}
+    , logger{wl_display_add_protocol_logger(display, log_message, this)}
+{
+}
+
+protocol_logger::~protocol_logger()
+{
+    if (logger) {
+        wl_protocol_logger_destroy(logger);
+    }
+}
+
+void protocol_logger::add(void const* owner,
+                          protocol_direction direction,
+                          char const* interface,
+                          char const* message,
+                          handler handler)
+{
+    entries.push_back({
+        .owner = owner,
+        .direction = direction,
+        .interface = interface ? interface : "",
+        .message = message ? message : "",
+        .handler = std::move(handler),
+    });
+    resolved.clear();
+}
+
+void protocol_logger::remove(void const* owner)
+{
+    entries.remove_if([owner](auto const& entry) { return entry.owner == owner; });
+    resolved.clear();
+}
+
+void protocol_logger::handle(protocol_direction direction,
+                             wl_protocol_logger_message const& message)
+{
+    for (auto entry : resolve(direction, message)) {
+        entry->handler(message);
+    }
+}
+
+std::vector<protocol_logger::entry const*> const&
+protocol_logger::resolve(protocol_direction direction, wl_protocol_logger_message const& message)
+{
+    auto [it, inserted] = resolved.try_emplace(message.message);
+    if (!inserted) {
+        return it->second;
+    }
+
+    std::string_view const interface = wl_resource_get_class(message.resource);
+    std::string_view const name = message.message->name;
+
+    for (auto const& entry : entries) {
+        if (entry.direction == direction
+            && (entry.interface.empty() || entry.interface == interface)
+            && (entry.message.empty() || entry.message == name)) {
+            it->second.push_back(&entry);
+        }
+    }
+    return it->second;
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct wl_display;
+struct wl_message;
+struct wl_protocol_logger;
+struct wl_protocol_logger_message;
+
+namespace theseus_ship::base
+{
+
+enum class protocol_direction {
+    request,
+    event,
+};
+
+/**
+ * Dispatches the messages of the Wayland server to the handlers registered for them through a
+ * single protocol logger on the display. The names of interface and message are compared only the
+ * first time a message is seen. Afterwards its handlers are found by a lookup of its signature.
+ *
+ * Handlers must not add or remove handlers.
+ */
+class protocol_logger
+{
+public:
+    using handler = std::function<void(wl_protocol_logger_message const&)>;
+
+    explicit protocol_logger(wl_display* display);
+    ~protocol_logger();
+
+    protocol_logger(protocol_logger const&) = delete;
+    protocol_logger& operator=(protocol_logger const&) = delete;
+
+    /**
+     * Calls @p handler for @p message of @p interface until handlers of @p owner are removed. A
+     * null @p interface or @p message matches all.
+     */
+    void add(void const* owner,
+             protocol_direction direction,
+             char const* interface,
+             char const* message,
+             handler handler);
+
+    /// Removes all handlers added with @p owner.
+    void remove(void const* owner);
+
+    void handle(protocol_direction direction, wl_protocol_logger_message const& message);
+
+    wl_display* const display;
+
+private:
+    struct entry {
+        void const* owner;
+        protocol_direction direction;
+        std::string interface;
+        std::string message;
+        protocol_logger::handler handler;
+    };
+
+    std::vector<entry const*> const& resolve(protocol_direction direction,
+                                             wl_protocol_logger_message const& message);
+
+    wl_protocol_logger* logger;
+    std::list<entry> entries;
+
+    // Messages are static descriptions of the interfaces, unique for each message.
+    std::unordered_map<wl_message const*, std::vector<entry const*>> resolved;
+};
+
+}
@@ -0,0 +1,80 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QDebug>
+#include <QProcessEnvironment>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Sends READY=1 to the service manager with the sd_notify protocol when NOTIFY_SOCKET is set.
+ * The variable is removed from @p environment, so launched processes do not notify in our name.
+ */
+inline void sd_notify_ready(QProcessEnvironment& environment, QByteArray const& status)
+{
+    auto const path = qgetenv("NOTIFY_SOCKET");
+    environment.remove(QStringLiteral("NOTIFY_SOCKET"));
+
+    if (path.isEmpty()) {
+        return;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (static_cast<size_t>(path.size()) >= sizeof(address.sun_path)) {
+        qWarning() << "NOTIFY_SOCKET path too long:" << path;
+        return;
+    }
+    memcpy(address.sun_path, path.constData(), path.size());
+
+    // A leading @ denotes a socket in the abstract namespace.
+    if (address.sun_path[0] == '@') {
+        address.sun_path[0] = '\0';
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        qWarning() << "Failed to create notification socket:" << strerror(errno);
+        return;
+    }
+
+    QByteArray const message = "READY=1\nSTATUS=" + status + '\n';
+    auto const length = offsetof(sockaddr_un, sun_path) + path.size();
+
+    if (sendto(fd,
+               message.constData(),
+               message.size(),
+               MSG_NOSIGNAL,
+               reinterpret_cast<sockaddr*>(&address),
+               length)
+        < 0) {
+        qWarning() << "Failed to notify service manager:" << strerror(errno);
+    }
+    close(fd);
+}
+
+/**
+ * Writes the name of the Wayland socket followed by a newline to @p fd and closes it. The reader
+ * knows from this that clients can connect now.
+ */
+inline void write_ready_fd(int fd, QByteArray const& socket_name)
+{
+    QByteArray const message = socket_name + '\n';
+    if (write(fd, message.constData(), message.size()) != message.size()) {
+        qWarning() << "Failed to write to ready fd" << fd << strerror(errno);
+    }
+    close(fd);
+}
+
+}
@@ -0,0 +1,331 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "scheduling.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+constexpr std::chrono::seconds thread_rescan_interval{5};
+// Rescans without a new or renamed thread after which rescanning stops.
+constexpr int stable_rescans_limit{6};
+
+std::optional<scheduling_policy> parse_policy(QString const& name)
+{
+    if (name.isEmpty()) {
+        return scheduling_policy::keep;
+    }
+    if (name == QStringLiteral("nice")) {
+        return scheduling_policy::nice;
+    }
+    if (name == QStringLiteral("fifo")) {
+        return scheduling_policy::fifo;
+    }
+    if (name == QStringLiteral("rr")) {
+        return scheduling_policy::round_robin;
+    }
+    return std::nullopt;
+}
+
+std::optional<cpu_set_t> const& affinity_for(scheduling_settings const& settings, thread_role role)
+{
+    switch (role) {
+    case thread_role::render:
+        return settings.render_affinity ? settings.render_affinity : settings.main_affinity;
+    case thread_role::main:
+    default:
+        return settings.main_affinity;
+    }
+}
+
+void set_affinity(pid_t tid, cpu_set_t const& set)
+{
+    if (sched_setaffinity(tid, sizeof(set), &set) != 0) {
+        qWarning() << "Failed to set CPU affinity" << cpu_list_to_string(set) << "of thread" << tid
+                   << strerror(errno);
+    }
+}
+
+bool has_affinity(scheduling_settings const& settings)
+{
+    return settings.main_affinity || settings.render_affinity;
+}
+
+void set_policy(pid_t tid, scheduling_settings const& settings)
+{
+    switch (settings.policy) {
+    case scheduling_policy::keep:
+        return;
+    case scheduling_policy::nice: {
+        // Children and new threads must not inherit a negative nice value.
+        sched_param param{};
+        if (sched_setscheduler(tid, SCHED_OTHER | SCHED_RESET_ON_FORK, &param) != 0) {
+            qWarning() << "Failed to set scheduling policy of thread" << tid << strerror(errno);
+        }
+        if (setpriority(PRIO_PROCESS, tid, settings.priority) != 0) {
+            qWarning() << "Failed to set nice value" << settings.priority << "of thread" << tid
+                       << strerror(errno);
+        }
+        return;
+    }
+    case scheduling_policy::fifo:
+    case scheduling_policy::round_robin: {
+        auto const policy = settings.policy == scheduling_policy::fifo ? SCHED_FIFO : SCHED_RR;
+        sched_param param{};
+        param.sched_priority = std::clamp(settings.priority,
+                                          sched_get_priority_min(policy),
+                                          sched_get_priority_max(policy));
+
+        // Children and new threads must not inherit the realtime policy.
+        if (sched_setscheduler(tid, policy | SCHED_RESET_ON_FORK, &param) != 0) {
+            qWarning() << "Failed to set realtime scheduling policy of thread" << tid
+                       << strerror(errno);
+        }
+        return;
+    }
+    }
+}
+
+void restore_policy(pid_t tid, int nice)
+{
+    sched_param param{};
+    if (sched_setscheduler(tid, SCHED_OTHER, &param) != 0
+        || setpriority(PRIO_PROCESS, tid, nice) != 0) {
+        qWarning() << "Failed to reset scheduling policy of thread" << tid << strerror(errno);
+    }
+}
+
+}
+
+std::optional<cpu_set_t> parse_cpu_list(QString const& list)
+{
+    if (list.trimmed().isEmpty()) {
+        return std::nullopt;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (auto const& range : list.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        auto const bounds = range.trimmed().split(QLatin1Char('-'));
+        bool ok_first{false};
+        bool ok_last{false};
+        auto const first = bounds.at(0).toInt(&ok_first);
+        auto const last = bounds.size() > 1 ? bounds.at(1).toInt(&ok_last) : first;
+
+        if (!ok_first || (bounds.size() > 1 && !ok_last) || bounds.size() > 2 || first < 0
+            || last < first || last >= CPU_SETSIZE) {
+            qWarning() << "Invalid CPU list" << list;
+            return std::nullopt;
+        }
+
+        for (int cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    return set;
+}
+
+QString cpu_list_to_string(cpu_set_t const& set)
+{
+    QStringList ranges;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) {
+            continue;
+        }
+        auto last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set)) {
+            last++;
+        }
+        ranges << (last == cpu ? QString::number(cpu) : QStringLiteral("%1-%2").arg(cpu).arg(last));
+        cpu = last;
+    }
+
+    return ranges.join(QLatin1Char(','));
+}
+
+thread_role thread_role_from_name(QString const& name)
+{
+    if (name.startsWith(QStringLiteral("QSGRender"))) {
+        return thread_role::render;
+    }
+    return thread_role::main;
+}
+
+thread_scheduling::thread_scheduling()
+{
+    CPU_ZERO(&original_cpus);
+    sched_getaffinity(0, sizeof(original_cpus), &original_cpus);
+    original_nice_value = getpriority(PRIO_PROCESS, 0);
+
+    rescan_timer.setInterval(thread_rescan_interval);
+    QObject::connect(&rescan_timer, &QTimer::timeout, [this] { rescan(); });
+}
+
+void thread_scheduling::set(scheduling_settings const& settings)
+{
+    // Settings that were applied before and are now removed are reset once on all threads.
+    reset_policy = this->settings.policy != scheduling_policy::keep
+        && settings.policy == scheduling_policy::keep;
+    reset_affinity = has_affinity(this->settings);
+
+    this->settings = settings;
+    threads.clear();
+    stable_rescans = 0;
+    rescan();
+
+    reset_policy = false;
+    reset_affinity = false;
+
+    if (settings.policy != scheduling_policy::keep || has_affinity(settings)) {
+        rescan_timer.start();
+    } else {
+        rescan_timer.stop();
+    }
+}
+
+cpu_set_t const& thread_scheduling::original_affinity() const
+{
+    return original_cpus;
+}
+
+int thread_scheduling::original_nice() const
+{
+    return original_nice_value;
+}
+
+void thread_scheduling::rescan()
+{
+    auto const tasks
+        = QDir(QStringLiteral("/proc/self/task")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    std::map<pid_t, QString> current;
+    bool changed{false};
+
+    for (auto const& task : tasks) {
+        QFile comm(QStringLiteral("/proc/self/task/%1/comm").arg(task));
+        if (!comm.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        auto const tid = static_cast<pid_t>(task.toInt());
+        auto const name = QString::fromLocal8Bit(comm.readAll().trimmed());
+        current[tid] = name;
+
+        // Threads are usually named right after they were created, so a renamed thread may have
+        // a different role now.
+        if (auto it = threads.find(tid); it != threads.end() && it->second == name) {
+            continue;
+        }
+        apply(tid, thread_role_from_name(name));
+        changed = true;
+    }
+
+    threads = std::move(current);
+
+    stable_rescans = changed ? 0 : stable_rescans + 1;
+    if (stable_rescans >= stable_rescans_limit) {
+        rescan_timer.stop();
+    }
+}
+
+void thread_scheduling::apply(pid_t tid, thread_role role) const
+{
+    if (tid == getpid() || role != thread_role::main) {
+        if (settings.policy != scheduling_policy::keep) {
+            set_policy(tid, settings);
+        } else if (reset_policy) {
+            restore_policy(tid, original_nice_value);
+        }
+    }
+
+    if (auto const& affinity = affinity_for(settings, role)) {
+        set_affinity(tid, *affinity);
+    } else if (reset_affinity) {
+        set_affinity(tid, original_cpus);
+    }
+}
+
+QString describe_scheduling(pid_t tid)
+{
+    auto const policy = sched_getscheduler(tid);
+
+    sched_param param{};
+    sched_getparam(tid, &param);
+
+    errno = 0;
+    auto const nice = getpriority(PRIO_PROCESS, tid ? tid : gettid());
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    sched_getaffinity(tid, sizeof(set), &set);
+
+    QString policy_name;
+    switch (policy & ~SCHED_RESET_ON_FORK) {
+    case SCHED_FIFO:
+        policy_name = QStringLiteral("SCHED_FIFO priority %1").arg(param.sched_priority);
+        break;
+    case SCHED_RR:
+        policy_name = QStringLiteral("SCHED_RR priority %1").arg(param.sched_priority);
+        break;
+    case SCHED_BATCH:
+        policy_name = QStringLiteral("SCHED_BATCH nice %1").arg(nice);
+        break;
+    case SCHED_IDLE:
+        policy_name = QStringLiteral("SCHED_IDLE");
+        break;
+    default:
+        policy_name = QStringLiteral("SCHED_OTHER nice %1").arg(nice);
+        break;
+    }
+
+    return policy_name + QStringLiteral(", CPUs ") + cpu_list_to_string(set);
+}
+
+void scheduling_options::add_to(QCommandLineParser& parser) const
+{
+    parser.addOption(policy);
+    parser.addOption(priority);
+    parser.addOption(main_affinity);
+    parser.addOption(render_affinity);
+}
+
+scheduling_settings scheduling_options::read(QCommandLineParser const& parser,
+                                             KConfigGroup const& config) const
+{
+    auto value = [&](QCommandLineOption const& option, char const* key) {
+        return parser.isSet(option) ? parser.value(option) : config.readEntry(key, QString());
+    };
+
+    scheduling_settings settings;
+
+    if (auto const policy = parse_policy(value(this->policy, "Policy"))) {
+        settings.policy = *policy;
+    } else {
+        qWarning() << "Unknown scheduling policy" << value(this->policy, "Policy");
+    }
+
+    settings.priority = value(priority, "Priority").toInt();
+    settings.main_affinity = parse_cpu_list(value(main_affinity, "MainThreadAffinity"));
+    settings.render_affinity = parse_cpu_list(value(render_affinity, "RenderThreadAffinity"));
+
+    return settings;
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <KLocalizedString>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <map>
+#include <optional>
+#include <sched.h>
+
+namespace theseus_ship::base
+{
+
+enum class scheduling_policy {
+    keep,
+    nice,
+    fifo,
+    round_robin,
+};
+
+/**
+ * Threads with own CPU affinity settings. They are identified by their name, so the names are a
+ * contract with the code creating the threads: render threads are the ones Qt Quick's threaded
+ * render loop starts, which it names QSGRenderThread. Threads of other names are helper threads
+ * and get the settings of the main thread.
+ */
+enum class thread_role {
+    main,
+    render,
+};
+
+struct scheduling_settings {
+    scheduling_policy policy{scheduling_policy::keep};
+    // The static priority for realtime policies, or the nice value.
+    int priority{0};
+
+    std::optional<cpu_set_t> main_affinity;
+    std::optional<cpu_set_t> render_affinity;
+};
+
+/// Parses CPU lists like "0-3,6,8-9".
+std::optional<cpu_set_t> parse_cpu_list(QString const& list);
+QString cpu_list_to_string(cpu_set_t const& set);
+
+thread_role thread_role_from_name(QString const& name);
+
+/**
+ * Applies scheduling settings to the threads of the process. The policy is set for the main thread
+ * and the render threads, helper threads keep theirs. It is set with
+ * SCHED_RESET_ON_FORK, so launched processes and threads created later do not inherit a realtime
+ * policy or a negative nice value. The affinity is set according to the role of each thread.
+ *
+ * The platforms create their threads on demand, so the threads are rescanned periodically and
+ * new or renamed ones get their settings then. Rescanning stops once the threads have not changed
+ * for a few rescans, threads started later get their settings on the next call to set(). When a
+ * setting is removed, the threads get back the policy and affinity the process had when this was
+ * created.
+ */
+class thread_scheduling
+{
+public:
+    thread_scheduling();
+
+    void set(scheduling_settings const& settings);
+
+    /// The affinity and nice value of the process before any settings were applied.
+    cpu_set_t const& original_affinity() const;
+    int original_nice() const;
+
+private:
+    void rescan();
+    void apply(pid_t tid, thread_role role) const;
+
+    scheduling_settings settings;
+    // Whether the policy and affinities must be reset on threads that do not get one.
+    bool reset_policy{false};
+    bool reset_affinity{false};
+
+    cpu_set_t original_cpus;
+    int original_nice_value{0};
+
+    // Threads the settings were applied to, with their name at that time.
+    std::map<pid_t, QString> threads;
+    QTimer rescan_timer;
+    int stable_rescans{0};
+};
+
+/// Describes the effective policy, priority and affinity of a thread, 0 for the calling one.
+QString describe_scheduling(pid_t tid = 0);
+
+/**
+ * Command line options for the scheduling settings. They take precedence over the ones in the
+ * Scheduling group of kwinrc.
+ */
+struct scheduling_options {
+    QCommandLineOption policy{
+        QStringLiteral("sched-policy"),
+        i18n("Scheduling policy of the compositor: \"rr\", \"fifo\" or \"nice\"."),
+        QStringLiteral("policy"),
+    };
+    QCommandLineOption priority{
+        QStringLiteral("sched-priority"),
+        i18n("Realtime priority for the \"rr\" and \"fifo\" policies, nice value otherwise."),
+        QStringLiteral("priority"),
+    };
+    QCommandLineOption main_affinity{
+        QStringLiteral("cpu-affinity"),
+        i18n("CPUs the main thread and helper threads may run on, for example \"0-3,6\"."),
+        QStringLiteral("cpus"),
+    };
+    QCommandLineOption render_affinity{
+        QStringLiteral("render-cpu-affinity"),
+        i18n("CPUs the Qt Quick render threads may run on."),
+        QStringLiteral("cpus"),
+    };
+
+    void add_to(QCommandLineParser& parser) const;
+    scheduling_settings read(QCommandLineParser const& parser, KConfigGroup const& config) const;
+};
+
+}
@@ -0,0 +1,77 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Delivers a signal to the event loop through a signalfd. The signal must be blocked in all
+ * threads, so it has to be blocked in main() before any thread is started.
+ */
+class signal_notifier
+{
+public:
+    explicit signal_notifier(int signal)
+    {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, signal);
+
+        fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd < 0) {
+            qWarning() << "Failed to create signalfd for" << strsignal(signal) << strerror(errno);
+            return;
+        }
+
+        notifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Read);
+        QObject::connect(notifier.get(), &QSocketNotifier::activated, [this] { handle(); });
+    }
+
+    signal_notifier(signal_notifier const&) = delete;
+    signal_notifier& operator=(signal_notifier const&) = delete;
+
+    ~signal_notifier()
+    {
+        notifier.reset();
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    void add(std::function<void()> callback)
+    {
+        callbacks.push_back(std::move(callback));
+    }
+
+private:
+    void handle()
+    {
+        signalfd_siginfo info;
+        while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+            for (auto const& callback : callbacks) {
+                callback();
+            }
+        }
+    }
+
+    int fd{-1};
+    std::unique_ptr<QSocketNotifier> notifier;
+    std::vector<std::function<void()>> callbacks;
+};
+
+}
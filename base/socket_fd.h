@@ -0,0 +1,76 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QDebug>
+#include <QProcessEnvironment>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Returns the first socket passed by a service manager through socket activation, or -1. The
+ * variables of the protocol are removed from the environment of the compositor and from
+ * @p environment. All passed fds get FD_CLOEXEC, also the ones that are not used, so launched
+ * processes do not inherit them.
+ */
+inline int activated_socket(QProcessEnvironment& environment)
+{
+    environment.remove(QStringLiteral("LISTEN_PID"));
+    environment.remove(QStringLiteral("LISTEN_FDS"));
+    environment.remove(QStringLiteral("LISTEN_FDNAMES"));
+
+    bool ok{false};
+    auto const pid = qgetenv("LISTEN_PID").toInt(&ok);
+    auto const count = qgetenv("LISTEN_FDS").toInt();
+
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+
+    if (!ok || pid != getpid() || count < 1) {
+        return -1;
+    }
+
+    // Passed sockets start right after stderr.
+    for (int fd = 3; fd < 3 + count; fd++) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return 3;
+}
+
+/**
+ * Lets the display accept clients on an already bound and listening socket. Clients may connect
+ * before, they are accepted once the event loop runs.
+ */
+inline bool add_listening_socket(wl_display* display, int fd)
+{
+    int listening{0};
+    socklen_t length = sizeof(listening);
+    if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &length) != 0 || !listening) {
+        qWarning() << "File descriptor" << fd << "is not a listening socket";
+        return false;
+    }
+
+    // Launched processes must not accept clients in our name.
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (wl_display_add_socket_fd(display, fd) != 0) {
+        qWarning() << "Failed to add socket" << fd << "to the display:" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+}
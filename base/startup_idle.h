@@ -0,0 +1,59 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QAbstractEventDispatcher>
+#include <QObject>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+
+namespace theseus_ship::base
+{
+
+constexpr std::chrono::milliseconds startup_quiet_interval{50};
+constexpr std::chrono::milliseconds startup_idle_timeout{3000};
+
+/**
+ * Calls @p callback once the event loop went quiet after startup, that means it was not woken up
+ * for @p quiet_interval. This is a heuristic: usually the first frames have been rendered by then,
+ * but no presentation event is observed. In case the event loop never goes quiet, for example
+ * because of a startup animation, the callback is called at the latest after @p timeout.
+ */
+inline void on_startup_idle(QObject* context,
+                            std::function<void()> callback,
+                            std::chrono::milliseconds quiet_interval = startup_quiet_interval,
+                            std::chrono::milliseconds timeout = startup_idle_timeout)
+{
+    auto quiet_timer = new QTimer(context);
+    quiet_timer->setSingleShot(true);
+    quiet_timer->setInterval(quiet_interval);
+
+    auto timeout_timer = new QTimer(context);
+    timeout_timer->setSingleShot(true);
+
+    auto finish = [quiet_timer, timeout_timer, callback = std::move(callback)] {
+        quiet_timer->stop();
+        timeout_timer->stop();
+        quiet_timer->deleteLater();
+        timeout_timer->deleteLater();
+        callback();
+    };
+
+    QObject::connect(quiet_timer, &QTimer::timeout, context, finish);
+    QObject::connect(timeout_timer, &QTimer::timeout, context, finish);
+
+    // Every time the event loop goes to sleep the quiet interval starts anew. The timer only fires
+    // when no other event woke up the loop in between.
+    QObject::connect(QAbstractEventDispatcher::instance(),
+                     &QAbstractEventDispatcher::aboutToBlock,
+                     quiet_timer,
+                     [quiet_timer] { quiet_timer->start(); });
+
+    timeout_timer->start(timeout);
+}
+
+}
@@ -0,0 +1,161 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "benchmark.h"
+
+#include <algorithm>
+#include <ctime>
+
+namespace theseus_ship::benchmark
+{
+
+namespace
+{
+
+std::chrono::nanoseconds process_cpu_time()
+{
+    timespec cpu;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    return std::chrono::seconds(cpu.tv_sec) + std::chrono::nanoseconds(cpu.tv_nsec);
+}
+
+QString format(percentiles const& values)
+{
+    auto ms = [](std::chrono::microseconds value) {
+        return QString::number(value.count() / 1000., 'f', 2);
+    };
+    return QStringLiteral("p50 %1 ms, p90 %2 ms, p99 %3 ms, max %4 ms")
+        .arg(ms(values.p50), ms(values.p90), ms(values.p99), ms(values.max));
+}
+
+}
+
+percentiles compute_percentiles(std::vector<std::chrono::microseconds> samples)
+{
+    if (samples.empty()) {
+        return {};
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double share) {
+        auto const index = static_cast<size_t>(share * (samples.size() - 1) + 0.5);
+        return samples.at(index);
+    };
+
+    return {
+        .p50 = at(0.5),
+        .p90 = at(0.9),
+        .p99 = at(0.99),
+        .max = samples.back(),
+    };
+}
+
+QString benchmark_report::to_string() const
+{
+    QStringList lines;
+
+    lines << QStringLiteral("Benchmark: %1 clients of %2x%3 at %4 Hz for %5 s")
+                 .arg(settings.clients)
+                 .arg(settings.client.width)
+                 .arg(settings.client.height)
+                 .arg(settings.client.rate)
+                 .arg(settings.duration.count());
+    lines << QStringLiteral("Frame interval: ") + format(frame_intervals);
+    lines << QStringLiteral("Commit to present: ") + format(latencies);
+    lines << QStringLiteral("Commits: %1, presented: %2, discarded: %3, skipped: %4")
+                 .arg(commits)
+                 .arg(presented)
+                 .arg(discarded)
+                 .arg(skipped);
+    lines << QStringLiteral("Compositor CPU: %1 %, clients CPU: %2 %")
+                 .arg(compositor_cpu * 100, 0, 'f', 1)
+                 .arg(clients_cpu * 100, 0, 'f', 1);
+
+    if (failed_clients) {
+        lines << QStringLiteral("Failed clients: %1").arg(failed_clients);
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+void setup_headless_environment()
+{
+    qputenv("WLR_BACKENDS", "headless");
+    qputenv("WLR_HEADLESS_OUTPUTS", "1");
+    qputenv("WLR_LIBINPUT_NO_DEVICES", "1");
+    qputenv("WLR_RENDERER", "pixman");
+    qputenv("KWIN_COMPOSE", "Q");
+}
+
+bool is_headless_environment()
+{
+    auto const backends = qgetenv("WLR_BACKENDS").split(',');
+    return std::all_of(backends.cbegin(), backends.cend(), [](auto const& backend) {
+        return backend.trimmed() == "headless";
+    });
+}
+
+benchmark::benchmark(benchmark_settings const& settings)
+    : settings{settings}
+{
+    timer.setSingleShot(true);
+    QObject::connect(&timer, &QTimer::timeout, [this] { stop(); });
+}
+
+void benchmark::start(std::string const& socket_name)
+{
+    begin = std::chrono::steady_clock::now();
+    process_cpu_begin = process_cpu_time();
+
+    for (int i = 0; i < settings.clients; i++) {
+        clients.push_back(std::make_unique<synthetic_client>(socket_name, settings.client));
+    }
+
+    timer.start(settings.duration);
+}
+
+void benchmark::stop()
+{
+    for (auto& client : clients) {
+        client->stop();
+    }
+
+    auto const wall_time = std::chrono::steady_clock::now() - begin;
+    auto const process_cpu = process_cpu_time() - process_cpu_begin;
+
+    benchmark_report report;
+    report.settings = settings;
+    std::vector<std::chrono::microseconds> intervals;
+    std::vector<std::chrono::microseconds> latencies;
+    std::chrono::nanoseconds clients_cpu{0};
+
+    for (auto const& client : clients) {
+        auto const& stats = client->stats();
+        intervals.insert(intervals.end(), stats.intervals.begin(), stats.intervals.end());
+        latencies.insert(latencies.end(), stats.latencies.begin(), stats.latencies.end());
+
+        report.commits += stats.commits;
+        report.presented += stats.latencies.size();
+        report.discarded += stats.discarded;
+        report.skipped += stats.skipped;
+        report.failed_clients += stats.failed ? 1 : 0;
+        clients_cpu += stats.cpu_time;
+    }
+    clients.clear();
+
+    report.frame_intervals = compute_percentiles(std::move(intervals));
+    report.latencies = compute_percentiles(std::move(latencies));
+
+    auto const wall = std::chrono::duration<double>(wall_time).count();
+    report.clients_cpu = std::chrono::duration<double>(clients_cpu).count() / wall;
+    report.compositor_cpu
+        = std::chrono::duration<double>(process_cpu - clients_cpu).count() / wall;
+
+    if (finished) {
+        finished(report);
+    }
+}
+
+}
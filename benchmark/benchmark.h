@@ -0,0 +1,83 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "synthetic_client.h"
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace theseus_ship::benchmark
+{
+
+struct benchmark_settings {
+    int clients{4};
+    std::chrono::seconds duration{10};
+    client_settings client;
+};
+
+struct percentiles {
+    std::chrono::microseconds p50{0};
+    std::chrono::microseconds p90{0};
+    std::chrono::microseconds p99{0};
+    std::chrono::microseconds max{0};
+};
+
+percentiles compute_percentiles(std::vector<std::chrono::microseconds> samples);
+
+struct benchmark_report {
+    benchmark_settings settings;
+    percentiles frame_intervals;
+    percentiles latencies;
+    uint64_t commits{0};
+    uint64_t presented{0};
+    uint64_t discarded{0};
+    uint64_t skipped{0};
+    int failed_clients{0};
+    // Share of one CPU core used by the compositor, excluding the synthetic clients.
+    double compositor_cpu{0};
+    double clients_cpu{0};
+
+    QString to_string() const;
+};
+
+/// Environment for running the compositor on a virtual output without DRM device or GPU.
+void setup_headless_environment();
+
+/// Whether only the headless backend is used, so no real input devices are added.
+bool is_headless_environment();
+
+/**
+ * Runs synthetic clients against the compositor for a fixed duration. Afterwards the report is
+ * handed to the finished callback.
+ */
+class benchmark
+{
+public:
+    explicit benchmark(benchmark_settings const& settings);
+
+    void start(std::string const& socket_name);
+
+    std::function<void(benchmark_report const&)> finished;
+
+private:
+    void stop();
+
+    benchmark_settings const settings;
+    std::vector<std::unique_ptr<synthetic_client>> clients;
+    QTimer timer;
+
+    std::chrono::nanoseconds process_cpu_begin{0};
+    std::chrono::steady_clock::time_point begin;
+};
+
+}
@@ -0,0 +1,242 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "input_recording.h"
+
+#include <como/input/event.h>
+#include <como/input/keyboard.h>
+#include <como/input/platform.h>
+#include <como/input/pointer.h>
+#include <como/input/touch.h>
+
+#include <QDebug>
+#include <QObject>
+#include <array>
+#include <ctime>
+#include <limits>
+#include <optional>
+
+namespace theseus_ship::benchmark
+{
+
+inline uint32_t input_event_time()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint32_t>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+/**
+ * Records the events of all input devices of the platform with the timestamps libinput gave them
+ * into a file. It can be replayed with input_replay.
+ *
+ * Frame events carry no timestamp and are recorded with the one of the last event of their
+ * device. Added and removed devices are recorded with the current time of the monotonic clock,
+ * which libinput uses as well. At most 256 devices are recorded, later ones are ignored.
+ */
+template<typename Platform>
+class input_recorder
+{
+public:
+    input_recorder(Platform& platform, QString const& path)
+        : writer{path}
+    {
+        for (auto pointer : platform.pointers) {
+            add_pointer(pointer);
+        }
+        for (auto keyboard : platform.keyboards) {
+            add_keyboard(keyboard);
+        }
+        for (auto touch : platform.touchs) {
+            add_touch(touch);
+        }
+
+        auto platform_qobject = platform.qobject.get();
+        QObject::connect(platform_qobject,
+                         &como::input::platform_qobject::pointer_added,
+                         &qobject,
+                         [this](auto pointer) { add_pointer(pointer); });
+        QObject::connect(platform_qobject,
+                         &como::input::platform_qobject::keyboard_added,
+                         &qobject,
+                         [this](auto keyboard) { add_keyboard(keyboard); });
+        QObject::connect(platform_qobject,
+                         &como::input::platform_qobject::touch_added,
+                         &qobject,
+                         [this](auto touch) { add_touch(touch); });
+    }
+
+    bool is_open() const
+    {
+        return writer.is_open();
+    }
+
+private:
+    std::optional<uint8_t> add_device(QObject* device, device_kind kind)
+    {
+        if (next_device > std::numeric_limits<uint8_t>::max()) {
+            qWarning() << "Too many input devices, further devices are not recorded.";
+            return {};
+        }
+
+        auto const index = static_cast<uint8_t>(next_device++);
+        record(input_event_time(),
+               {.type = record_type::device_added, .device = index, .code = uint16_t(kind)});
+
+        QObject::connect(device, &QObject::destroyed, &qobject, [this, index] {
+            record(input_event_time(), {.type = record_type::device_removed, .device = index});
+        });
+        return index;
+    }
+
+    void add_pointer(como::input::pointer* pointer)
+    {
+        auto const added = add_device(pointer, device_kind::pointer);
+        if (!added) {
+            return;
+        }
+        auto const index = *added;
+
+        QObject::connect(
+            pointer,
+            &como::input::pointer::motion,
+            &qobject,
+            [this, index](como::input::motion_event const& event) {
+                record(event.base.time_msec,
+                       {.type = record_type::pointer_motion,
+                        .device = index,
+                        .x = float(event.delta.x()),
+                        .y = float(event.delta.y()),
+                        .unaccel_x = float(event.unaccel_delta.x()),
+                        .unaccel_y = float(event.unaccel_delta.y())});
+            });
+        QObject::connect(
+            pointer,
+            &como::input::pointer::motion_absolute,
+            &qobject,
+            [this, index](como::input::motion_absolute_event const& event) {
+                record(event.base.time_msec,
+                       {.type = record_type::pointer_motion_absolute,
+                        .device = index,
+                        .x = float(event.pos.x()),
+                        .y = float(event.pos.y())});
+            });
+        QObject::connect(
+            pointer,
+            &como::input::pointer::button_changed,
+            &qobject,
+            [this, index](como::input::button_event const& event) {
+                record(event.base.time_msec,
+                       {.type = record_type::pointer_button,
+                        .device = index,
+                        .code = uint16_t(event.key),
+                        .state = event.state == como::input::button_state::pressed});
+            });
+        QObject::connect(
+            pointer,
+            &como::input::pointer::axis_changed,
+            &qobject,
+            [this, index](como::input::axis_event const& event) {
+                record(event.base.time_msec,
+                       {.type = record_type::pointer_axis,
+                        .device = index,
+                        .code = uint16_t(event.orientation),
+                        .state = uint32_t(event.source),
+                        .x = float(event.delta),
+                        .y = float(event.delta_discrete)});
+            });
+        QObject::connect(pointer, &como::input::pointer::frame, &qobject, [this, index] {
+            record(last_times[index], {.type = record_type::pointer_frame, .device = index});
+        });
+    }
+
+    void add_keyboard(como::input::keyboard* keyboard)
+    {
+        auto const added = add_device(keyboard, device_kind::keyboard);
+        if (!added) {
+            return;
+        }
+        auto const index = *added;
+
+        QObject::connect(keyboard,
+                         &como::input::keyboard::key_changed,
+                         &qobject,
+                         [this, index](como::input::key_event const& event) {
+                             record(event.base.time_msec,
+                                    {.type = record_type::key,
+                                     .device = index,
+                                     .code = uint16_t(event.keycode),
+                                     .state = event.state == como::input::key_state::pressed});
+                         });
+    }
+
+    void add_touch(como::input::touch* touch)
+    {
+        auto const added = add_device(touch, device_kind::touch);
+        if (!added) {
+            return;
+        }
+        auto const index = *added;
+
+        QObject::connect(touch,
+                         &como::input::touch::down,
+                         &qobject,
+                         [this, index](como::input::touch_down_event const& event) {
+                             record(event.base.time_msec,
+                                    {.type = record_type::touch_down,
+                                     .device = index,
+                                     .code = uint16_t(event.id),
+                                     .x = float(event.pos.x()),
+                                     .y = float(event.pos.y())});
+                         });
+        QObject::connect(touch,
+                         &como::input::touch::motion,
+                         &qobject,
+                         [this, index](como::input::touch_motion_event const& event) {
+                             record(event.base.time_msec,
+                                    {.type = record_type::touch_motion,
+                                     .device = index,
+                                     .code = uint16_t(event.id),
+                                     .x = float(event.pos.x()),
+                                     .y = float(event.pos.y())});
+                         });
+        QObject::connect(touch,
+                         &como::input::touch::up,
+                         &qobject,
+                         [this, index](como::input::touch_up_event const& event) {
+                             record(event.base.time_msec,
+                                    {.type = record_type::touch_up,
+                                     .device = index,
+                                     .code = uint16_t(event.id)});
+                         });
+        QObject::connect(touch,
+                         &como::input::touch::cancel,
+                         &qobject,
+                         [this, index](como::input::touch_cancel_event const& event) {
+                             record(event.base.time_msec,
+                                    {.type = record_type::touch_cancel, .device = index});
+                         });
+        QObject::connect(touch, &como::input::touch::frame, &qobject, [this, index] {
+            record(last_times[index], {.type = record_type::touch_frame, .device = index});
+        });
+    }
+
+    void record(uint32_t time_msec, input_record record)
+    {
+        // Event timestamps are milliseconds of the monotonic clock.
+        last_times[record.device] = time_msec;
+        writer.add(uint64_t(time_msec) * 1000, record);
+    }
+
+    recording_writer writer;
+    int next_device{0};
+    // The time of the last record of each device.
+    std::array<uint32_t, std::numeric_limits<uint8_t>::max() + 1> last_times{};
+    QObject qobject;
+};
+
+}
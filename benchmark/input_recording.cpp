@@ -0,0 +1,159 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "input_recording.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace theseus_ship::benchmark
+{
+
+namespace
+{
+
+struct file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+constexpr char magic[8] = {'T', 'S', 'I', 'N', 'P', 'U', 'T', '\0'};
+constexpr uint32_t version{2};
+
+// Records are written in batches. Input comes in bursts of a few records per frame.
+constexpr size_t flush_threshold{256};
+constexpr std::chrono::seconds flush_interval{1};
+
+}
+
+recording_writer::recording_writer(QString const& path)
+    : file{path}
+{
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open input recording" << path << file.errorString();
+        return;
+    }
+
+    file_header header{.magic = {}, .version = version, .record_size = sizeof(input_record)};
+    memcpy(header.magic, magic, sizeof(magic));
+    file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    buffer.reserve(flush_threshold);
+    QObject::connect(&flush_timer, &QTimer::timeout, [this] { flush(); });
+    flush_timer.start(flush_interval);
+}
+
+recording_writer::~recording_writer()
+{
+    flush();
+}
+
+bool recording_writer::is_open() const
+{
+    return file.isOpen();
+}
+
+void recording_writer::add(uint64_t time, input_record record)
+{
+    if (!file.isOpen()) {
+        return;
+    }
+    if (!start) {
+        start = time;
+    }
+
+    // Records without a timestamp of their own are taken from the clock when they are recorded,
+    // which can be ahead of the timestamps of events still queued.
+    auto const relative = time > *start ? time - *start : 0;
+    record.time = std::max(relative, last_time);
+    last_time = record.time;
+    buffer.push_back(record);
+
+    if (buffer.size() >= flush_threshold) {
+        flush();
+    }
+}
+
+void recording_writer::flush()
+{
+    if (buffer.empty()) {
+        return;
+    }
+
+    auto const size = static_cast<qint64>(buffer.size() * sizeof(input_record));
+    if (file.write(reinterpret_cast<char const*>(buffer.data()), size) != size
+        || !file.flush()) {
+        qWarning() << "Failed to write input recording" << file.fileName() << file.errorString();
+    }
+    buffer.clear();
+}
+
+std::optional<std::vector<input_record>> read_recording(QString const& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to open input recording" << path << file.errorString();
+        return {};
+    }
+
+    file_header header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)
+        || memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version
+        || header.record_size != sizeof(input_record)) {
+        qWarning() << "Not an input recording of this version:" << path;
+        return {};
+    }
+
+    auto const data = file.readAll();
+    if (data.size() % sizeof(input_record)) {
+        // The compositor may have crashed while writing the last batch.
+        qWarning() << "Input recording" << path << "ends with an incomplete record";
+    }
+
+    std::vector<input_record> records(data.size() / sizeof(input_record));
+    memcpy(records.data(), data.constData(), records.size() * sizeof(input_record));
+    return records;
+}
+
+recording_player::recording_player(std::vector<input_record> records)
+    : records{std::move(records)}
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, [this] { play_due(); });
+}
+
+void recording_player::start()
+{
+    begin = std::chrono::steady_clock::now();
+    next = 0;
+    play_due();
+}
+
+void recording_player::play_due()
+{
+    auto const elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - begin)
+                             .count();
+
+    // Records falling behind because of a busy event loop are played at once, like queued input.
+    for (; next < records.size() && records[next].time <= static_cast<uint64_t>(elapsed); next++) {
+        if (play) {
+            play(records[next]);
+        }
+    }
+
+    if (next == records.size()) {
+        qInfo() << "Input replay finished";
+        return;
+    }
+
+    auto const due = std::chrono::microseconds(records[next].time - elapsed);
+    timer.start(std::chrono::ceil<std::chrono::milliseconds>(due));
+}
+
+}
@@ -0,0 +1,112 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QTimer>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace theseus_ship::benchmark
+{
+
+enum class device_kind : uint8_t {
+    pointer,
+    keyboard,
+    touch,
+};
+
+enum class record_type : uint8_t {
+    // The code is the device kind.
+    device_added,
+    device_removed,
+    // Relative motion in x and y, without acceleration in unaccel_x and unaccel_y.
+    pointer_motion,
+    // Absolute position in x and y.
+    pointer_motion_absolute,
+    // The code is the button and the state whether it is pressed.
+    pointer_button,
+    // The code is the orientation, the state the source, x the delta and y the discrete delta.
+    pointer_axis,
+    pointer_frame,
+    // The code is the key and the state whether it is pressed.
+    key,
+    // The code is the touch id.
+    touch_down,
+    touch_up,
+    touch_motion,
+    touch_cancel,
+    touch_frame,
+};
+
+/// A single input event as stored in the file, in host byte order.
+struct input_record {
+    // Microseconds since the start of the recording.
+    uint64_t time;
+    record_type type;
+    // Index of the device in order of its device_added record.
+    uint8_t device;
+    uint16_t code;
+    uint32_t state;
+    float x;
+    float y;
+    float unaccel_x;
+    float unaccel_y;
+};
+
+static_assert(sizeof(input_record) == 32);
+
+/**
+ * Writes input records into a file, which starts with a short header. The timestamps are taken
+ * relative to the first record. They never go backwards, a record with an earlier time than the
+ * one before gets the time of the one before.
+ */
+class recording_writer
+{
+public:
+    explicit recording_writer(QString const& path);
+    ~recording_writer();
+
+    bool is_open() const;
+
+    /// The @p time is in microseconds of the monotonic clock.
+    void add(uint64_t time, input_record record);
+    void flush();
+
+private:
+    QFile file;
+    std::optional<uint64_t> start;
+    uint64_t last_time{0};
+    std::vector<input_record> buffer;
+    QTimer flush_timer;
+};
+
+std::optional<std::vector<input_record>> read_recording(QString const& path);
+
+/// Hands out the records of a recording with their original spacing in time.
+class recording_player
+{
+public:
+    explicit recording_player(std::vector<input_record> records);
+
+    void start();
+
+    std::function<void(input_record const&)> play;
+
+private:
+    void play_due();
+
+    std::vector<input_record> const records;
+    size_t next{0};
+    std::chrono::steady_clock::time_point begin;
+    QTimer timer;
+};
+
+}
@@ -0,0 +1,206 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "input_recorder.h"
+#include "input_recording.h"
+
+#include <como/input/event.h>
+#include <como/input/keyboard.h>
+#include <como/input/platform.h>
+#include <como/input/pointer.h>
+#include <como/input/touch.h>
+
+#include <map>
+#include <memory>
+
+namespace theseus_ship::benchmark
+{
+
+/**
+ * Replays a recording through virtual devices, which are added to the platform like the fake
+ * input devices. The compositor only replays with the headless backend, which has no real
+ * devices that could interleave their events.
+ */
+template<typename Platform>
+class input_replay
+{
+public:
+    input_replay(Platform& platform, std::vector<input_record> records)
+        : platform{platform}
+        , player{std::move(records)}
+    {
+        player.play = [this](auto const& record) { play(record); };
+    }
+
+    ~input_replay()
+    {
+        for (auto& [index, pointer] : pointers) {
+            como::input::platform_remove_pointer(pointer.get(), platform);
+        }
+        for (auto& [index, keyboard] : keyboards) {
+            como::input::platform_remove_keyboard(keyboard.get(), platform);
+        }
+        for (auto& [index, touch] : touchs) {
+            como::input::platform_remove_touch(touch.get(), platform);
+        }
+    }
+
+    void start()
+    {
+        player.start();
+    }
+
+private:
+    void play(input_record const& record)
+    {
+        // The time is taken anew, so the clients see consistent timestamps.
+        auto const time = input_event_time();
+        auto const index = record.device;
+
+        switch (record.type) {
+        case record_type::device_added:
+            add_device(index, static_cast<device_kind>(record.code));
+            return;
+        case record_type::device_removed:
+            remove_device(index);
+            return;
+        default:
+            break;
+        }
+
+        if (auto it = pointers.find(index); it != pointers.end()) {
+            play_pointer(*it->second, record, time);
+        } else if (auto it = keyboards.find(index); it != keyboards.end()) {
+            if (record.type == record_type::key) {
+                auto keyboard = it->second.get();
+                Q_EMIT keyboard->key_changed({
+                    .keycode = record.code,
+                    .state = record.state ? como::input::key_state::pressed
+                                          : como::input::key_state::released,
+                    .requires_modifier_update = false,
+                    .base = {keyboard, time},
+                });
+            }
+        } else if (auto it = touchs.find(index); it != touchs.end()) {
+            play_touch(*it->second, record, time);
+        }
+    }
+
+    void play_pointer(como::input::pointer& pointer, input_record const& record, uint32_t time)
+    {
+        QPointF const position{record.x, record.y};
+
+        switch (record.type) {
+        case record_type::pointer_motion:
+            Q_EMIT pointer.motion({
+                .delta = position,
+                .unaccel_delta = {record.unaccel_x, record.unaccel_y},
+                .base = {&pointer, time},
+            });
+            break;
+        case record_type::pointer_motion_absolute:
+            Q_EMIT pointer.motion_absolute({.pos = position, .base = {&pointer, time}});
+            break;
+        case record_type::pointer_button:
+            Q_EMIT pointer.button_changed({
+                .key = record.code,
+                .state = record.state ? como::input::button_state::pressed
+                                      : como::input::button_state::released,
+                .base = {&pointer, time},
+            });
+            break;
+        case record_type::pointer_axis:
+            Q_EMIT pointer.axis_changed({
+                .orientation = static_cast<como::input::axis_orientation>(record.code),
+                .delta = record.x,
+                .delta_discrete = static_cast<int32_t>(record.y),
+                .source = static_cast<como::input::axis_source>(record.state),
+                .base = {&pointer, time},
+            });
+            break;
+        case record_type::pointer_frame:
+            Q_EMIT pointer.frame();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void play_touch(como::input::touch& touch, input_record const& record, uint32_t time)
+    {
+        QPointF const position{record.x, record.y};
+        auto const id = static_cast<int32_t>(record.code);
+
+        switch (record.type) {
+        case record_type::touch_down:
+            Q_EMIT touch.down({.id = id, .pos = position, .base = {&touch, time}});
+            break;
+        case record_type::touch_motion:
+            Q_EMIT touch.motion({.id = id, .pos = position, .base = {&touch, time}});
+            break;
+        case record_type::touch_up:
+            Q_EMIT touch.up({.id = id, .base = {&touch, time}});
+            break;
+        case record_type::touch_cancel:
+            Q_EMIT touch.cancel({.base = {&touch, time}});
+            break;
+        case record_type::touch_frame:
+            Q_EMIT touch.frame();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void add_device(uint8_t index, device_kind kind)
+    {
+        remove_device(index);
+
+        switch (kind) {
+        case device_kind::pointer: {
+            auto& pointer = pointers[index];
+            pointer = std::make_unique<como::input::pointer>();
+            como::input::platform_add_pointer(pointer.get(), platform);
+            break;
+        }
+        case device_kind::keyboard: {
+            auto& keyboard = keyboards[index];
+            keyboard = std::make_unique<como::input::keyboard>();
+            como::input::platform_add_keyboard(keyboard.get(), platform);
+            break;
+        }
+        case device_kind::touch: {
+            auto& touch = touchs[index];
+            touch = std::make_unique<como::input::touch>();
+            como::input::platform_add_touch(touch.get(), platform);
+            break;
+        }
+        }
+    }
+
+    void remove_device(uint8_t index)
+    {
+        if (auto node = pointers.extract(index); !node.empty()) {
+            como::input::platform_remove_pointer(node.mapped().get(), platform);
+        }
+        if (auto node = keyboards.extract(index); !node.empty()) {
+            como::input::platform_remove_keyboard(node.mapped().get(), platform);
+        }
+        if (auto node = touchs.extract(index); !node.empty()) {
+            como::input::platform_remove_touch(node.mapped().get(), platform);
+        }
+    }
+
+    Platform& platform;
+    recording_player player;
+
+    std::map<uint8_t, std::unique_ptr<como::input::pointer>> pointers;
+    std::map<uint8_t, std::unique_ptr<como::input::keyboard>> keyboards;
+    std::map<uint8_t, std::unique_ptr<como::input::touch>> touchs;
+};
+
+}
@@ -0,0 +1,116 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "server_paths.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QStringList>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    using namespace theseus_ship::benchmark;
+
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("kwin_wayland_server_bench"));
+
+    QStringList names;
+    for (size_t index = 0; index < static_cast<size_t>(server_path::count); index++) {
+        names << to_string(static_cast<server_path>(index));
+    }
+
+    server_path_settings settings;
+
+    QCommandLineOption path_option{
+        QStringLiteral("path"),
+        QStringLiteral("Server path to stress, one of %1. Can be repeated, all by default.")
+            .arg(names.join(QStringLiteral(", "))),
+        QStringLiteral("name"),
+    };
+    QCommandLineOption operations_option{
+        QStringLiteral("operations"),
+        QStringLiteral("Operations per run."),
+        QStringLiteral("count"),
+        QString::number(settings.operations),
+    };
+    QCommandLineOption runs_option{
+        QStringLiteral("runs"),
+        QStringLiteral("Runs of each path after a warm-up run."),
+        QStringLiteral("count"),
+        QString::number(settings.runs),
+    };
+    QCommandLineOption depth_option{
+        QStringLiteral("subsurface-depth"),
+        QStringLiteral("Depth of the subsurface tree."),
+        QStringLiteral("count"),
+        QString::number(settings.subsurface_depth),
+    };
+    QCommandLineOption rects_option{
+        QStringLiteral("damage-rects"),
+        QStringLiteral("Damage rectangles per commit."),
+        QStringLiteral("count"),
+        QString::number(settings.damage_rects),
+    };
+    QCommandLineOption pid_option{
+        QStringLiteral("pid"),
+        QStringLiteral("Process of the compositor, when it is not the one listening on the socket "
+                       "like with the wrapper."),
+        QStringLiteral("pid"),
+    };
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Stresses single paths of the Wayland server of the compositor at "
+                       "WAYLAND_DISPLAY and reports their cost per operation. For stable numbers "
+                       "run it as the session of a headless compositor without other clients, "
+                       "for example: WLR_BACKENDS=headless kwin_wayland --exit-with-session "
+                       "kwin_wayland_server_bench"));
+    parser.addHelpOption();
+    parser.addOption(path_option);
+    parser.addOption(operations_option);
+    parser.addOption(runs_option);
+    parser.addOption(depth_option);
+    parser.addOption(rects_option);
+    parser.addOption(pid_option);
+    parser.process(app);
+
+    std::vector<server_path> paths;
+    for (auto const& name : parser.values(path_option)) {
+        auto const path = server_path_from_string(name);
+        if (!path) {
+            std::cerr << "Unknown server path: " << qPrintable(name) << std::endl;
+            return 1;
+        }
+        paths.push_back(*path);
+    }
+    if (paths.empty()) {
+        for (size_t index = 0; index < static_cast<size_t>(server_path::count); index++) {
+            paths.push_back(static_cast<server_path>(index));
+        }
+    }
+
+    settings.operations = std::max(1, parser.value(operations_option).toInt());
+    settings.runs = std::max(1, parser.value(runs_option).toInt());
+    settings.subsurface_depth = std::max(1, parser.value(depth_option).toInt());
+    settings.damage_rects = std::max(1, parser.value(rects_option).toInt());
+
+    server_path_client client;
+    if (!client.connect(parser.value(pid_option).toInt())) {
+        return 1;
+    }
+
+    auto failed = false;
+    for (auto path : paths) {
+        auto const result = client.run(path, settings);
+        std::cout << qPrintable(result.to_string()) << std::endl;
+        failed |= result.failed;
+    }
+
+    return failed ? 1 : 0;
+}
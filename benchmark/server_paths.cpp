@@ -0,0 +1,653 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "server_paths.h"
+
+#include "wayland-xdg-shell-client-protocol.h"
+
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include <wayland-client.h>
+
+namespace theseus_ship::benchmark
+{
+
+namespace
+{
+
+// The pool is sparse, so only the pages the compositor reads are backed by memory.
+constexpr int32_t pool_size{64 * 1024 * 1024};
+
+// Size of windows that are not maximized and of subsurfaces.
+constexpr int32_t window_size{256};
+constexpr int32_t subsurface_size{16};
+
+// The compositor may be busy with earlier operations, but must not ignore a request.
+constexpr std::chrono::seconds configure_timeout{5};
+
+void handle_ping(void* /*data*/, xdg_wm_base* wm_base, uint32_t serial)
+{
+    xdg_wm_base_pong(wm_base, serial);
+}
+
+xdg_wm_base_listener const wm_base_listener{
+    .ping = handle_ping,
+};
+
+void handle_global_remove(void* /*data*/, wl_registry* /*registry*/, uint32_t /*name*/)
+{
+}
+
+void handle_toplevel_close(void* /*data*/, xdg_toplevel* /*toplevel*/)
+{
+}
+
+// The peer of the socket is the process that listens on it. That is the wrapper when the
+// compositor got the socket passed with LISTEN_FDS, so the peer is only taken if it is the
+// compositor itself.
+pid_t peer_pid(int fd)
+{
+    ucred credentials{};
+    socklen_t length{sizeof(credentials)};
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) {
+        return 0;
+    }
+
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(credentials.pid));
+    if (!comm.open(QIODevice::ReadOnly) || comm.readAll().trimmed() != "kwin_wayland") {
+        return 0;
+    }
+    return credentials.pid;
+}
+
+std::chrono::nanoseconds median(std::vector<std::chrono::nanoseconds> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.at(values.size() / 2);
+}
+
+}
+
+QString to_string(server_path path)
+{
+    switch (path) {
+    case server_path::commit_storm:
+        return QStringLiteral("commit-storm");
+    case server_path::subsurface_tree:
+        return QStringLiteral("subsurface-tree");
+    case server_path::damage_rects:
+        return QStringLiteral("damage-rects");
+    case server_path::configure_cycles:
+        return QStringLiteral("configure-cycles");
+    case server_path::buffer_churn:
+        return QStringLiteral("buffer-churn");
+    case server_path::count:
+        break;
+    }
+    return {};
+}
+
+std::optional<server_path> server_path_from_string(QString const& name)
+{
+    for (size_t index = 0; index < static_cast<size_t>(server_path::count); index++) {
+        auto const path = static_cast<server_path>(index);
+        if (to_string(path) == name) {
+            return path;
+        }
+    }
+    return {};
+}
+
+QString server_path_result::to_string() const
+{
+    auto const name = theseus_ship::benchmark::to_string(path);
+    if (failed) {
+        return name + QStringLiteral(": failed");
+    }
+
+    auto us = [](std::chrono::nanoseconds value) {
+        return QString::number(value.count() / 1000., 'f', 2);
+    };
+    return QStringLiteral("%1: %2 operations, per operation wall %3 us (min %4 us), "
+                          "compositor %5 us (min %6 us)")
+        .arg(name)
+        .arg(operations)
+        .arg(us(wall_median), us(wall_min), us(compositor_median), us(compositor_min));
+}
+
+server_path_client::server_path_client() = default;
+
+server_path_client::~server_path_client()
+{
+    destroy_buffers();
+
+    if (pool) {
+        wl_shm_pool_destroy(pool);
+    }
+    if (wm_base) {
+        xdg_wm_base_destroy(wm_base);
+    }
+    if (shm) {
+        wl_shm_destroy(shm);
+    }
+    if (subcompositor) {
+        wl_subcompositor_destroy(subcompositor);
+    }
+    if (compositor) {
+        wl_compositor_destroy(compositor);
+    }
+    if (registry) {
+        wl_registry_destroy(registry);
+    }
+    if (display) {
+        wl_display_disconnect(display);
+    }
+}
+
+void server_path_client::handle_global(void* data,
+                                       wl_registry* registry,
+                                       uint32_t name,
+                                       char const* interface,
+                                       uint32_t version)
+{
+    auto client = static_cast<server_path_client*>(data);
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0 && version >= 4) {
+        client->compositor = static_cast<wl_compositor*>(
+            wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+    } else if (strcmp(interface, wl_subcompositor_interface.name) == 0) {
+        client->subcompositor = static_cast<wl_subcompositor*>(
+            wl_registry_bind(registry, name, &wl_subcompositor_interface, 1));
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        client->shm = static_cast<wl_shm*>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        client->wm_base = static_cast<xdg_wm_base*>(
+            wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+        xdg_wm_base_add_listener(client->wm_base, &wm_base_listener, client);
+    }
+}
+
+void server_path_client::handle_toplevel_configure(void* data,
+                                                   xdg_toplevel* /*toplevel*/,
+                                                   int32_t width,
+                                                   int32_t height,
+                                                   wl_array* /*states*/)
+{
+    auto win = static_cast<window*>(data);
+    win->width = width;
+    win->height = height;
+}
+
+void server_path_client::handle_configure(void* data, xdg_surface* /*surface*/, uint32_t serial)
+{
+    auto win = static_cast<window*>(data);
+    win->serial = serial;
+    win->configured = true;
+}
+
+void server_path_client::handle_release(void* data, wl_buffer* buffer)
+{
+    auto client = static_cast<server_path_client*>(data);
+    client->buffers.erase(buffer);
+    wl_buffer_destroy(buffer);
+}
+
+bool server_path_client::connect(pid_t pid)
+{
+    display = wl_display_connect(nullptr);
+    if (!display) {
+        qWarning() << "Failed to connect to the compositor.";
+        return false;
+    }
+
+    compositor_pid = pid ? pid : peer_pid(wl_display_get_fd(display));
+    if (!compositor_pid) {
+        qWarning() << "The compositor process is unknown, its time will not be measured."
+                   << "Pass its pid with --pid.";
+    }
+
+    static wl_registry_listener const registry_listener{
+        .global = handle_global,
+        .global_remove = handle_global_remove,
+    };
+
+    registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registry_listener, this);
+    wl_display_roundtrip(display);
+
+    if (!compositor || !subcompositor || !shm || !wm_base) {
+        qWarning() << "The compositor is missing required globals.";
+        return false;
+    }
+
+    auto fd = memfd_create("kwin-server-bench", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, pool_size) != 0) {
+        qWarning() << "Failed to create the buffer pool:" << strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    pool = wl_shm_create_pool(shm, fd, pool_size);
+    close(fd);
+
+    return wl_display_roundtrip(display) >= 0;
+}
+
+server_path_result server_path_client::run(server_path path, server_path_settings const& settings)
+{
+    server_path_result result{.path = path, .operations = settings.operations};
+    std::vector<std::chrono::nanoseconds> wall;
+    std::vector<std::chrono::nanoseconds> compositor;
+
+    // The first run warms up caches and allocations on both sides.
+    for (int run = 0; run <= settings.runs; run++) {
+        auto const success = run_once(path, settings);
+        destroy_buffers();
+
+        if (!success || wl_display_roundtrip(display) < 0) {
+            result.failed = true;
+            return result;
+        }
+        if (run == 0) {
+            continue;
+        }
+
+        wall.push_back(run_wall / settings.operations);
+        compositor.push_back(run_compositor / settings.operations);
+    }
+
+    result.wall_median = median(wall);
+    result.wall_min = *std::min_element(wall.cbegin(), wall.cend());
+    result.compositor_median = median(compositor);
+    result.compositor_min = *std::min_element(compositor.cbegin(), compositor.cend());
+    return result;
+}
+
+bool server_path_client::run_once(server_path path, server_path_settings const& settings)
+{
+    switch (path) {
+    case server_path::commit_storm:
+        return commit_storm(settings.operations);
+    case server_path::subsurface_tree:
+        return subsurface_tree(settings.operations, settings.subsurface_depth);
+    case server_path::damage_rects:
+        return damage_rects(settings.operations, settings.damage_rects);
+    case server_path::configure_cycles:
+        return configure_cycles(settings.operations);
+    case server_path::buffer_churn:
+        return buffer_churn(settings.operations);
+    case server_path::count:
+        break;
+    }
+    return false;
+}
+
+bool server_path_client::commit_storm(int operations)
+{
+    window win;
+    auto success = map_window(win);
+
+    if (success) {
+        measure_begin();
+        for (int op = 0; op < operations && success; op++) {
+            wl_surface_damage_buffer(win.surface, 0, 0, 1, 1);
+            wl_surface_commit(win.surface);
+            success = flush();
+        }
+        success = success && measure_end();
+    }
+
+    destroy_window(win);
+    return success;
+}
+
+bool server_path_client::subsurface_tree(int operations, int depth)
+{
+    window win;
+    auto success = map_window(win);
+
+    std::vector<wl_surface*> surfaces;
+    std::vector<wl_subsurface*> subsurfaces;
+
+    if (success) {
+        auto buffer = create_buffer(subsurface_size, subsurface_size);
+        auto parent = win.surface;
+
+        for (int level = 0; level < depth; level++) {
+            auto surface = wl_compositor_create_surface(compositor);
+            auto subsurface = wl_subcompositor_get_subsurface(subcompositor, surface, parent);
+            wl_subsurface_set_position(subsurface, 1, 1);
+            wl_surface_attach(surface, buffer, 0, 0);
+            wl_surface_damage_buffer(surface, 0, 0, subsurface_size, subsurface_size);
+
+            surfaces.push_back(surface);
+            subsurfaces.push_back(subsurface);
+            parent = surface;
+        }
+    }
+
+    // Synchronized state is applied with the parent, so the tree is committed from the leaf up.
+    auto commit_tree = [&] {
+        if (!surfaces.empty()) {
+            wl_surface_damage_buffer(surfaces.back(), 0, 0, 1, 1);
+        }
+        std::for_each(surfaces.rbegin(), surfaces.rend(), wl_surface_commit);
+        wl_surface_commit(win.surface);
+    };
+
+    if (success) {
+        commit_tree();
+        success = wl_display_roundtrip(display) >= 0;
+    }
+    if (success) {
+        measure_begin();
+        for (int op = 0; op < operations && success; op++) {
+            commit_tree();
+            success = flush();
+        }
+        success = success && measure_end();
+    }
+
+    std::for_each(subsurfaces.rbegin(), subsurfaces.rend(), wl_subsurface_destroy);
+    std::for_each(surfaces.rbegin(), surfaces.rend(), wl_surface_destroy);
+    destroy_window(win);
+    return success;
+}
+
+bool server_path_client::damage_rects(int operations, int rects)
+{
+    window win;
+    auto success = map_window(win);
+
+    if (success) {
+        // Every other pixel in every other row, so the rectangles cannot be merged.
+        auto const columns = std::max(1, win.width / 2);
+
+        measure_begin();
+        for (int op = 0; op < operations && success; op++) {
+            for (int rect = 0; rect < rects; rect++) {
+                wl_surface_damage_buffer(
+                    win.surface, rect % columns * 2, rect / columns * 2 % win.height, 1, 1);
+            }
+            wl_surface_commit(win.surface);
+            success = flush();
+        }
+        success = success && measure_end();
+    }
+
+    destroy_window(win);
+    return success;
+}
+
+bool server_path_client::configure_cycles(int operations)
+{
+    window win;
+    auto success = map_window(win);
+
+    // The two sizes alternate, so their buffers are reused.
+    std::map<std::pair<int32_t, int32_t>, wl_buffer*> sized_buffers;
+
+    if (success) {
+        measure_begin();
+        for (int op = 0; op < operations && success; op++) {
+            if (op % 2) {
+                xdg_toplevel_unset_maximized(win.toplevel);
+            } else {
+                xdg_toplevel_set_maximized(win.toplevel);
+            }
+            if (!wait_configure(win)) {
+                success = false;
+                break;
+            }
+
+            auto const width = win.width > 0 ? win.width : window_size;
+            auto const height = win.height > 0 ? win.height : window_size;
+            auto& buffer = sized_buffers[{width, height}];
+            if (!buffer) {
+                buffer = create_buffer(width, height);
+            }
+
+            xdg_surface_ack_configure(win.xdg_surf, win.serial);
+            wl_surface_attach(win.surface, buffer, 0, 0);
+            wl_surface_damage_buffer(win.surface, 0, 0, width, height);
+            wl_surface_commit(win.surface);
+            success = buffer && flush();
+        }
+        success = success && measure_end();
+    }
+
+    destroy_window(win);
+    return success;
+}
+
+bool server_path_client::buffer_churn(int operations)
+{
+    static wl_buffer_listener const release_listener{
+        .release = handle_release,
+    };
+
+    window win;
+    auto success = map_window(win);
+
+    if (success) {
+        measure_begin();
+        for (int op = 0; op < operations && success; op++) {
+            auto buffer = create_buffer(win.width, win.height);
+            if (!buffer) {
+                success = false;
+                break;
+            }
+            wl_buffer_add_listener(buffer, &release_listener, this);
+
+            wl_surface_attach(win.surface, buffer, 0, 0);
+            wl_surface_damage_buffer(win.surface, 0, 0, win.width, win.height);
+            wl_surface_commit(win.surface);
+            success = flush();
+        }
+        success = success && measure_end();
+    }
+
+    destroy_window(win);
+    return success;
+}
+
+bool server_path_client::map_window(window& win)
+{
+    static xdg_surface_listener const surface_listener{
+        .configure = handle_configure,
+    };
+    static xdg_toplevel_listener const toplevel_listener{
+        .configure = handle_toplevel_configure,
+        .close = handle_toplevel_close,
+    };
+
+    win.surface = wl_compositor_create_surface(compositor);
+    win.xdg_surf = xdg_wm_base_get_xdg_surface(wm_base, win.surface);
+    xdg_surface_add_listener(win.xdg_surf, &surface_listener, &win);
+    win.toplevel = xdg_surface_get_toplevel(win.xdg_surf);
+    xdg_toplevel_add_listener(win.toplevel, &toplevel_listener, &win);
+    xdg_toplevel_set_title(win.toplevel, "kwin server path benchmark");
+    wl_surface_commit(win.surface);
+
+    if (!wait_configure(win)) {
+        return false;
+    }
+
+    if (win.width <= 0 || win.height <= 0) {
+        win.width = window_size;
+        win.height = window_size;
+    }
+
+    auto buffer = create_buffer(win.width, win.height);
+    if (!buffer) {
+        return false;
+    }
+
+    xdg_surface_ack_configure(win.xdg_surf, win.serial);
+    wl_surface_attach(win.surface, buffer, 0, 0);
+    wl_surface_damage_buffer(win.surface, 0, 0, win.width, win.height);
+    wl_surface_commit(win.surface);
+
+    return wl_display_roundtrip(display) >= 0;
+}
+
+void server_path_client::destroy_window(window& win)
+{
+    if (win.toplevel) {
+        xdg_toplevel_destroy(win.toplevel);
+    }
+    if (win.xdg_surf) {
+        xdg_surface_destroy(win.xdg_surf);
+    }
+    if (win.surface) {
+        wl_surface_destroy(win.surface);
+    }
+    win = {};
+}
+
+bool server_path_client::wait_configure(window& win)
+{
+    win.configured = false;
+
+    auto const deadline = std::chrono::steady_clock::now() + configure_timeout;
+    while (!win.configured) {
+        if (!flush()) {
+            return false;
+        }
+
+        auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            qWarning() << "The compositor did not configure the window in time.";
+            return false;
+        }
+
+        pollfd fd{.fd = wl_display_get_fd(display), .events = POLLIN, .revents = 0};
+        if (poll(&fd, 1, static_cast<int>(remaining.count())) < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+wl_buffer* server_path_client::create_buffer(int32_t width, int32_t height)
+{
+    if (static_cast<int64_t>(width) * height * 4 > pool_size) {
+        qWarning() << "A buffer of" << width << "x" << height << "does not fit into the pool.";
+        return nullptr;
+    }
+
+    auto buffer
+        = wl_shm_pool_create_buffer(pool, 0, width, height, width * 4, WL_SHM_FORMAT_XRGB8888);
+    buffers.insert(buffer);
+    return buffer;
+}
+
+void server_path_client::destroy_buffers()
+{
+    for (auto buffer : buffers) {
+        wl_buffer_destroy(buffer);
+    }
+    buffers.clear();
+}
+
+bool server_path_client::flush()
+{
+    // Reading the events keeps the compositor from blocking on a full socket towards us.
+    if (!dispatch_pending()) {
+        return false;
+    }
+
+    pollfd fd{.fd = wl_display_get_fd(display), .events = POLLOUT, .revents = 0};
+
+    while (wl_display_flush(display) < 0) {
+        if (errno != EAGAIN) {
+            return false;
+        }
+        fd.events = POLLIN | POLLOUT;
+        if (poll(&fd, 1, -1) < 0 && errno != EINTR) {
+            return false;
+        }
+        if ((fd.revents & POLLIN) && !dispatch_pending()) {
+            return false;
+        }
+    }
+
+    // The next operation must not run into a full socket while its requests are written.
+    fd.events = POLLOUT;
+    while (poll(&fd, 1, -1) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool server_path_client::dispatch_pending()
+{
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) < 0) {
+            return false;
+        }
+    }
+
+    pollfd fd{.fd = wl_display_get_fd(display), .events = POLLIN, .revents = 0};
+    if (poll(&fd, 1, 0) > 0 && (fd.revents & POLLIN)) {
+        if (wl_display_read_events(display) < 0) {
+            return false;
+        }
+    } else {
+        wl_display_cancel_read(display);
+    }
+
+    return wl_display_dispatch_pending(display) >= 0;
+}
+
+void server_path_client::measure_begin()
+{
+    compositor_begin = compositor_time();
+    wall_begin = std::chrono::steady_clock::now();
+}
+
+bool server_path_client::measure_end()
+{
+    // The compositor processed all operations once it answers the roundtrip.
+    if (wl_display_roundtrip(display) < 0) {
+        return false;
+    }
+
+    run_wall = std::chrono::steady_clock::now() - wall_begin;
+    run_compositor = compositor_time() - compositor_begin;
+    return true;
+}
+
+std::chrono::nanoseconds server_path_client::compositor_time() const
+{
+    if (!compositor_pid) {
+        return {};
+    }
+
+    // The first field is the time the main thread ran on a CPU in nanoseconds.
+    QFile file(QStringLiteral("/proc/%1/schedstat").arg(compositor_pid));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return std::chrono::nanoseconds(file.readAll().split(' ').value(0).toLongLong());
+}
+
+}
@@ -0,0 +1,161 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QString>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <sys/types.h>
+
+struct wl_array;
+struct wl_buffer;
+struct wl_compositor;
+struct wl_display;
+struct wl_registry;
+struct wl_shm;
+struct wl_shm_pool;
+struct wl_subcompositor;
+struct wl_surface;
+struct xdg_surface;
+struct xdg_toplevel;
+struct xdg_wm_base;
+
+namespace theseus_ship::benchmark
+{
+
+/// Paths of the Wayland server that are stressed one at a time.
+enum class server_path {
+    // Commits of a single surface with minimal damage.
+    commit_storm,
+    // Updates of a chain of synchronized subsurfaces, committed from the leaf to the root.
+    subsurface_tree,
+    // Commits with many single pixel damage rectangles.
+    damage_rects,
+    // Toggling the maximized state and acknowledging each configure with a matching buffer.
+    configure_cycles,
+    // Commits of a newly created buffer each, which is destroyed once released.
+    buffer_churn,
+    count,
+};
+
+QString to_string(server_path path);
+std::optional<server_path> server_path_from_string(QString const& name);
+
+struct server_path_settings {
+    // Operations per run.
+    int operations{5000};
+    // Runs after a warm-up run. Results are the median and minimum of them.
+    int runs{5};
+    int subsurface_depth{32};
+    int damage_rects{256};
+};
+
+struct server_path_result {
+    server_path path;
+    int operations{0};
+
+    // Per operation. The compositor time is the CPU time of its main thread.
+    std::chrono::nanoseconds wall_median{0};
+    std::chrono::nanoseconds wall_min{0};
+    std::chrono::nanoseconds compositor_median{0};
+    std::chrono::nanoseconds compositor_min{0};
+
+    bool failed{false};
+
+    QString to_string() const;
+};
+
+/**
+ * A Wayland client for stressing single paths of the compositor. It runs on the calling thread.
+ * The cost on the compositor side is taken from the scheduler statistics of the compositor
+ * process, so it must run on the same machine.
+ */
+class server_path_client
+{
+public:
+    server_path_client();
+    ~server_path_client();
+
+    server_path_client(server_path_client const&) = delete;
+    server_path_client& operator=(server_path_client const&) = delete;
+
+    /**
+     * Connects to the compositor of WAYLAND_DISPLAY. Its time is measured from the process @p pid,
+     * or if it is 0 from the process at the other end of the socket, when that is kwin_wayland.
+     */
+    bool connect(pid_t pid);
+
+    server_path_result run(server_path path, server_path_settings const& settings);
+
+private:
+    struct window {
+        wl_surface* surface{nullptr};
+        xdg_surface* xdg_surf{nullptr};
+        xdg_toplevel* toplevel{nullptr};
+        bool configured{false};
+        uint32_t serial{0};
+        int32_t width{0};
+        int32_t height{0};
+    };
+
+    bool run_once(server_path path, server_path_settings const& settings);
+
+    bool commit_storm(int operations);
+    bool subsurface_tree(int operations, int depth);
+    bool damage_rects(int operations, int rects);
+    bool configure_cycles(int operations);
+    bool buffer_churn(int operations);
+
+    bool map_window(window& win);
+    void destroy_window(window& win);
+    bool wait_configure(window& win);
+
+    wl_buffer* create_buffer(int32_t width, int32_t height);
+    void destroy_buffers();
+
+    bool flush();
+    bool dispatch_pending();
+
+    /// Brackets the operations of a run, after their setup and before their teardown.
+    void measure_begin();
+    bool measure_end();
+    std::chrono::nanoseconds compositor_time() const;
+
+    static void handle_global(void* data,
+                              wl_registry* registry,
+                              uint32_t name,
+                              char const* interface,
+                              uint32_t version);
+    static void handle_toplevel_configure(void* data,
+                                          xdg_toplevel* toplevel,
+                                          int32_t width,
+                                          int32_t height,
+                                          wl_array* states);
+    static void handle_configure(void* data, xdg_surface* surface, uint32_t serial);
+    static void handle_release(void* data, wl_buffer* buffer);
+
+    wl_display* display{nullptr};
+    wl_registry* registry{nullptr};
+    wl_compositor* compositor{nullptr};
+    wl_subcompositor* subcompositor{nullptr};
+    wl_shm* shm{nullptr};
+    xdg_wm_base* wm_base{nullptr};
+
+    // All buffers start at the beginning of the pool. Their content is irrelevant.
+    wl_shm_pool* pool{nullptr};
+    std::set<wl_buffer*> buffers;
+
+    pid_t compositor_pid{0};
+
+    std::chrono::steady_clock::time_point wall_begin;
+    std::chrono::nanoseconds compositor_begin{0};
+    std::chrono::nanoseconds run_wall{0};
+    std::chrono::nanoseconds run_compositor{0};
+};
+
+}
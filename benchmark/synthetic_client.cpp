@@ -0,0 +1,480 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "synthetic_client.h"
+
+#include "wayland-presentation-time-client-protocol.h"
+#include "wayland-xdg-shell-client-protocol.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <wayland-client.h>
+
+namespace theseus_ship::benchmark
+{
+
+namespace
+{
+
+// One buffer can be on screen, one queued and one being drawn.
+constexpr size_t buffer_count{3};
+
+void handle_ping(void* /*data*/, xdg_wm_base* wm_base, uint32_t serial)
+{
+    xdg_wm_base_pong(wm_base, serial);
+}
+
+xdg_wm_base_listener const wm_base_listener{
+    .ping = handle_ping,
+};
+
+void handle_global_remove(void* /*data*/, wl_registry* /*registry*/, uint32_t /*name*/)
+{
+}
+
+void handle_clock_id(void* data, wp_presentation* /*presentation*/, uint32_t clock)
+{
+    *static_cast<clockid_t*>(data) = static_cast<clockid_t>(clock);
+}
+
+wp_presentation_listener const presentation_listener{
+    .clock_id = handle_clock_id,
+};
+
+void handle_configure(void* data, xdg_surface* surface, uint32_t serial)
+{
+    xdg_surface_ack_configure(surface, serial);
+    *static_cast<bool*>(data) = true;
+}
+
+xdg_surface_listener const surface_listener{
+    .configure = handle_configure,
+};
+
+void handle_release(void* data, wl_buffer* /*buffer*/)
+{
+    *static_cast<bool*>(data) = false;
+}
+
+wl_buffer_listener const buffer_listener{
+    .release = handle_release,
+};
+
+void handle_sync_done(void* data, wl_callback* callback, uint32_t /*serial*/)
+{
+    *static_cast<bool*>(data) = true;
+    wl_callback_destroy(callback);
+}
+
+wl_callback_listener const sync_listener{
+    .done = handle_sync_done,
+};
+
+void handle_sync_output(void* /*data*/,
+                        struct wp_presentation_feedback* /*feedback*/,
+                        wl_output* /*output*/)
+{
+}
+
+}
+
+synthetic_client::synthetic_client(std::string socket_name, client_settings const& settings)
+    : socket_name{std::move(socket_name)}
+    , settings{settings}
+    , stop_fd{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)}
+{
+    thread = std::thread([this] { run(); });
+}
+
+synthetic_client::~synthetic_client()
+{
+    stop();
+    if (stop_fd >= 0) {
+        close(stop_fd);
+    }
+}
+
+void synthetic_client::stop()
+{
+    if (!thread.joinable()) {
+        return;
+    }
+
+    uint64_t const value{1};
+    if (write(stop_fd, &value, sizeof(value)) != sizeof(value)) {
+        qWarning() << "Failed to stop synthetic client:" << strerror(errno);
+    }
+    thread.join();
+}
+
+client_stats const& synthetic_client::stats() const
+{
+    return result;
+}
+
+int64_t synthetic_client::clock_now() const
+{
+    timespec now;
+    clock_gettime(presentation_clock, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+void synthetic_client::handle_global(void* data,
+                                     wl_registry* registry,
+                                     uint32_t name,
+                                     char const* interface,
+                                     uint32_t version)
+{
+    auto client = static_cast<synthetic_client*>(data);
+
+    if (strcmp(interface, wl_compositor_interface.name) == 0 && version >= 4) {
+        client->compositor = static_cast<wl_compositor*>(
+            wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        client->shm = static_cast<wl_shm*>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        client->wm_base = static_cast<xdg_wm_base*>(
+            wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+        xdg_wm_base_add_listener(client->wm_base, &wm_base_listener, client);
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        client->presentation = static_cast<wp_presentation*>(
+            wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+        wp_presentation_add_listener(
+            client->presentation, &presentation_listener, &client->presentation_clock);
+    }
+}
+
+void synthetic_client::handle_presented(void* data,
+                                        struct wp_presentation_feedback* feedback,
+                                        uint32_t tv_sec_hi,
+                                        uint32_t tv_sec_lo,
+                                        uint32_t tv_nsec,
+                                        uint32_t /*refresh*/,
+                                        uint32_t /*seq_hi*/,
+                                        uint32_t /*seq_lo*/,
+                                        uint32_t /*flags*/)
+{
+    auto client = static_cast<synthetic_client*>(data);
+    auto const seconds = (static_cast<int64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+    auto const presented = seconds * 1000000000LL + tv_nsec;
+
+    if (auto it = client->pending.find(feedback); it != client->pending.end()) {
+        client->result.latencies.push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::nanoseconds(presented - it->second)));
+        client->pending.erase(it);
+    }
+
+    if (client->last_presented) {
+        client->result.intervals.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::nanoseconds(presented - client->last_presented)));
+    }
+    client->last_presented = presented;
+
+    wp_presentation_feedback_destroy(feedback);
+}
+
+void synthetic_client::handle_discarded(void* data, struct wp_presentation_feedback* feedback)
+{
+    auto client = static_cast<synthetic_client*>(data);
+    client->pending.erase(feedback);
+    client->result.discarded++;
+    wp_presentation_feedback_destroy(feedback);
+}
+
+bool synthetic_client::dispatch_until(bool const& done)
+{
+    // The compositor runs on the thread that stops this client. Waiting only on the display would
+    // deadlock then, so every wait also watches the stop request.
+    pollfd fds[] = {
+        {.fd = wl_display_get_fd(display), .events = POLLIN, .revents = 0},
+        {.fd = stop_fd, .events = POLLIN, .revents = 0},
+    };
+
+    while (true) {
+        if (wl_display_dispatch_pending(display) < 0) {
+            return false;
+        }
+        if (done) {
+            return true;
+        }
+        if (wl_display_prepare_read(display) != 0) {
+            continue;
+        }
+        wl_display_flush(display);
+
+        if (poll(fds, 2, -1) < 0) {
+            wl_display_cancel_read(display);
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            if (wl_display_read_events(display) < 0) {
+                return false;
+            }
+        } else {
+            wl_display_cancel_read(display);
+        }
+        if (fds[1].revents & POLLIN) {
+            return false;
+        }
+    }
+}
+
+bool synthetic_client::roundtrip()
+{
+    bool done{false};
+    auto callback = wl_display_sync(display);
+    wl_callback_add_listener(callback, &sync_listener, &done);
+
+    if (dispatch_until(done)) {
+        return true;
+    }
+    if (!done) {
+        wl_callback_destroy(callback);
+    }
+    return false;
+}
+
+bool synthetic_client::create_buffers()
+{
+    auto const stride = settings.width * 4;
+    auto const size = static_cast<size_t>(stride) * settings.height;
+    pool_size = size * buffer_count;
+
+    auto fd = memfd_create("kwin-benchmark-client", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, pool_size) != 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+
+    pool_data = mmap(nullptr, pool_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (pool_data == MAP_FAILED) {
+        pool_data = nullptr;
+        close(fd);
+        return false;
+    }
+
+    auto pool = wl_shm_create_pool(shm, fd, pool_size);
+    buffers.resize(buffer_count);
+
+    for (size_t i = 0; i < buffer_count; i++) {
+        auto& buffer = buffers.at(i);
+        buffer.native = wl_shm_pool_create_buffer(
+            pool, i * size, settings.width, settings.height, stride, WL_SHM_FORMAT_XRGB8888);
+        buffer.data = static_cast<char*>(pool_data) + i * size;
+        wl_buffer_add_listener(buffer.native, &buffer_listener, &buffer.busy);
+    }
+
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    return true;
+}
+
+bool synthetic_client::setup()
+{
+    display = wl_display_connect(socket_name.c_str());
+    if (!display) {
+        return false;
+    }
+
+    static wl_registry_listener const registry_listener{
+        .global = handle_global,
+        .global_remove = handle_global_remove,
+    };
+
+    registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &registry_listener, this);
+    if (!roundtrip()) {
+        return false;
+    }
+
+    if (!compositor || !shm || !wm_base || !presentation) {
+        qWarning() << "Synthetic client is missing required globals.";
+        return false;
+    }
+
+    // Receives the presentation clock.
+    if (!roundtrip()) {
+        return false;
+    }
+
+    surface = wl_compositor_create_surface(compositor);
+    xdg_surf = xdg_wm_base_get_xdg_surface(wm_base, surface);
+    xdg_surface_add_listener(xdg_surf, &surface_listener, &configured);
+    toplevel = xdg_surface_get_toplevel(xdg_surf);
+    xdg_toplevel_set_title(toplevel, "kwin benchmark client");
+    wl_surface_commit(surface);
+
+    if (!dispatch_until(configured)) {
+        return false;
+    }
+
+    return create_buffers();
+}
+
+void synthetic_client::commit_frame()
+{
+    auto it = std::find_if(
+        buffers.begin(), buffers.end(), [](auto const& buffer) { return !buffer.busy; });
+    if (it == buffers.end()) {
+        result.skipped++;
+        return;
+    }
+
+    // Every pixel changes, so the compositor has to upload the full buffer again.
+    auto const color = static_cast<uint32_t>(0xff000000 | (frame * 0x010307));
+    auto pixels = static_cast<uint32_t*>(it->data);
+    std::fill(pixels, pixels + settings.width * settings.height, color);
+    frame++;
+
+    static wp_presentation_feedback_listener const feedback_listener{
+        .sync_output = handle_sync_output,
+        .presented = handle_presented,
+        .discarded = handle_discarded,
+    };
+
+    auto feedback = wp_presentation_feedback(presentation, surface);
+    wp_presentation_feedback_add_listener(feedback, &feedback_listener, this);
+
+    wl_surface_attach(surface, it->native, 0, 0);
+    wl_surface_damage_buffer(surface, 0, 0, settings.width, settings.height);
+
+    pending.insert({feedback, clock_now()});
+    wl_surface_commit(surface);
+    it->busy = true;
+    result.commits++;
+}
+
+void synthetic_client::teardown()
+{
+    for (auto const& [feedback, commit] : pending) {
+        wp_presentation_feedback_destroy(feedback);
+    }
+    pending.clear();
+
+    for (auto& buffer : buffers) {
+        wl_buffer_destroy(buffer.native);
+    }
+    buffers.clear();
+
+    if (pool_data) {
+        munmap(pool_data, pool_size);
+    }
+
+    if (toplevel) {
+        xdg_toplevel_destroy(toplevel);
+    }
+    if (xdg_surf) {
+        xdg_surface_destroy(xdg_surf);
+    }
+    if (surface) {
+        wl_surface_destroy(surface);
+    }
+    if (presentation) {
+        wp_presentation_destroy(presentation);
+    }
+    if (wm_base) {
+        xdg_wm_base_destroy(wm_base);
+    }
+    if (shm) {
+        wl_shm_destroy(shm);
+    }
+    if (compositor) {
+        wl_compositor_destroy(compositor);
+    }
+    if (registry) {
+        wl_registry_destroy(registry);
+    }
+    if (display) {
+        wl_display_disconnect(display);
+    }
+}
+
+void synthetic_client::run()
+{
+    pthread_setname_np(pthread_self(), "kwin-bench-client");
+
+    if (!setup()) {
+        result.failed = true;
+        teardown();
+        return;
+    }
+
+    auto timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    auto const period = std::llround(1000000000. / settings.rate);
+    itimerspec spec{
+        .it_interval = {.tv_sec = period / 1000000000, .tv_nsec = period % 1000000000},
+        .it_value = {.tv_sec = 0, .tv_nsec = 1},
+    };
+    timerfd_settime(timer, 0, &spec, nullptr);
+
+    pollfd fds[] = {
+        {.fd = wl_display_get_fd(display), .events = POLLIN, .revents = 0},
+        {.fd = timer, .events = POLLIN, .revents = 0},
+        {.fd = stop_fd, .events = POLLIN, .revents = 0},
+    };
+
+    while (true) {
+        while (wl_display_prepare_read(display) != 0) {
+            wl_display_dispatch_pending(display);
+        }
+        wl_display_flush(display);
+
+        if (poll(fds, 3, -1) < 0) {
+            wl_display_cancel_read(display);
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            wl_display_read_events(display);
+        } else {
+            wl_display_cancel_read(display);
+        }
+        if (wl_display_dispatch_pending(display) < 0) {
+            result.failed = true;
+            break;
+        }
+
+        if (fds[2].revents & POLLIN) {
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t expirations;
+            if (read(timer, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                // Missed periods count as skipped commits.
+                result.skipped += expirations - 1;
+            }
+            commit_frame();
+        }
+    }
+
+    close(timer);
+
+    timespec cpu;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    result.cpu_time = std::chrono::seconds(cpu.tv_sec) + std::chrono::nanoseconds(cpu.tv_nsec);
+
+    teardown();
+}
+
+}
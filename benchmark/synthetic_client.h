@@ -0,0 +1,139 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct wl_buffer;
+struct wl_compositor;
+struct wl_display;
+struct wl_registry;
+struct wl_shm;
+struct wl_surface;
+struct wp_presentation;
+struct wp_presentation_feedback;
+struct xdg_surface;
+struct xdg_toplevel;
+struct xdg_wm_base;
+
+namespace theseus_ship::benchmark
+{
+
+struct client_settings {
+    int width{512};
+    int height{512};
+    // Commits per second.
+    double rate{60};
+};
+
+struct client_stats {
+    // Time from commit to presentation of each presented frame.
+    std::vector<std::chrono::microseconds> latencies;
+    // Time between two consecutive presented frames.
+    std::vector<std::chrono::microseconds> intervals;
+    uint64_t commits{0};
+    uint64_t discarded{0};
+    // Commits skipped because the compositor still held all buffers.
+    uint64_t skipped{0};
+    // CPU time the client thread consumed.
+    std::chrono::nanoseconds cpu_time{0};
+    bool failed{false};
+};
+
+/**
+ * A minimal xdg-shell client on its own thread. It commits shm buffers at a fixed rate and
+ * measures when they are presented through the presentation-time protocol.
+ */
+class synthetic_client
+{
+public:
+    synthetic_client(std::string socket_name, client_settings const& settings);
+    ~synthetic_client();
+
+    synthetic_client(synthetic_client const&) = delete;
+    synthetic_client& operator=(synthetic_client const&) = delete;
+
+    /// Stops the client, which disconnects from the compositor.
+    void stop();
+
+    /// Only valid after the client was stopped.
+    client_stats const& stats() const;
+
+private:
+    struct buffer {
+        wl_buffer* native{nullptr};
+        void* data{nullptr};
+        bool busy{false};
+    };
+
+    void run();
+    bool setup();
+
+    /// Dispatches events until @p done is set. Returns false if stopped or disconnected before.
+    bool dispatch_until(bool const& done);
+    bool roundtrip();
+
+    bool create_buffers();
+    void commit_frame();
+    void teardown();
+
+    static void handle_global(void* data,
+                              wl_registry* registry,
+                              uint32_t name,
+                              char const* interface,
+                              uint32_t version);
+    static void handle_presented(void* data,
+                                 struct wp_presentation_feedback* feedback,
+                                 uint32_t tv_sec_hi,
+                                 uint32_t tv_sec_lo,
+                                 uint32_t tv_nsec,
+                                 uint32_t refresh,
+                                 uint32_t seq_hi,
+                                 uint32_t seq_lo,
+                                 uint32_t flags);
+    static void handle_discarded(void* data, struct wp_presentation_feedback* feedback);
+
+    int64_t clock_now() const;
+
+    std::string const socket_name;
+    client_settings const settings;
+
+    wl_display* display{nullptr};
+    wl_registry* registry{nullptr};
+    wl_compositor* compositor{nullptr};
+    wl_shm* shm{nullptr};
+    xdg_wm_base* wm_base{nullptr};
+    wp_presentation* presentation{nullptr};
+    wl_surface* surface{nullptr};
+    xdg_surface* xdg_surf{nullptr};
+    xdg_toplevel* toplevel{nullptr};
+
+    std::vector<buffer> buffers;
+    void* pool_data{nullptr};
+    size_t pool_size{0};
+
+    bool configured{false};
+    clockid_t presentation_clock{CLOCK_MONOTONIC};
+    int64_t last_presented{0};
+    uint64_t frame{0};
+
+    // Commit time of each frame still waiting for presentation.
+    std::unordered_map<struct wp_presentation_feedback*, int64_t> pending;
+
+    client_stats result;
+
+    int stop_fd{-1};
+    std::thread thread;
+};
+
+}
@@ -8,3 +8,5 @@
 #if HAVE_BREEZE_DECO
 #define BREEZE_KDECORATION_PLUGIN_ID "${BREEZE_KDECORATION_PLUGIN_ID}"
 #endif
+
+#cmakedefine01 KWIN_BUILD_DBUS_ACCOUNTING
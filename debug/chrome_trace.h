@@ -0,0 +1,94 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <chrono>
+#include <unistd.h>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * A single event in the Chrome trace event format, which is understood by chrome://tracing,
+ * Perfetto and many other trace viewers. Events without duration are written as instant events.
+ */
+struct trace_event {
+    QString name;
+    QString category;
+    std::chrono::microseconds start{0};
+    std::chrono::microseconds duration{0};
+    bool instant{false};
+    pid_t tid{0};
+    QJsonObject args;
+};
+
+/// Timestamps are taken from the monotonic clock like the ones of ftrace markers.
+inline std::chrono::microseconds trace_clock_now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+}
+
+inline QJsonObject to_json(trace_event const& event)
+{
+    QJsonObject obj{
+        {QStringLiteral("name"), event.name},
+        {QStringLiteral("cat"), event.category},
+        {QStringLiteral("ph"), event.instant ? QStringLiteral("i") : QStringLiteral("X")},
+        {QStringLiteral("ts"), static_cast<qint64>(event.start.count())},
+        {QStringLiteral("pid"), static_cast<qint64>(getpid())},
+        {QStringLiteral("tid"), static_cast<qint64>(event.tid)},
+    };
+
+    if (event.instant) {
+        obj.insert(QStringLiteral("s"), QStringLiteral("t"));
+    } else {
+        obj.insert(QStringLiteral("dur"), static_cast<qint64>(event.duration.count()));
+    }
+    if (!event.args.isEmpty()) {
+        obj.insert(QStringLiteral("args"), event.args);
+    }
+
+    return obj;
+}
+
+inline QByteArray to_chrome_trace(std::vector<trace_event> const& events,
+                                  QJsonObject const& metadata = {})
+{
+    QJsonArray array;
+    for (auto const& event : events) {
+        array.append(to_json(event));
+    }
+
+    QJsonObject root{
+        {QStringLiteral("traceEvents"), array},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    if (!metadata.isEmpty()) {
+        root.insert(QStringLiteral("metadata"), metadata);
+    }
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+inline bool write_chrome_trace(QString const& path,
+                               std::vector<trace_event> const& events,
+                               QJsonObject const& metadata = {})
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(to_chrome_trace(events, metadata)) != -1;
+}
+
+}
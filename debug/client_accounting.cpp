@@ -0,0 +1,363 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "client_accounting.h"
+
+#include "base/protocol_logger.h"
+
+#include <QDBusConnection>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <ctime>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// Dmabufs are mostly of four byte formats. Their planes and modifiers are not accounted.
+constexpr int64_t dmabuf_bytes_per_pixel{4};
+
+std::chrono::nanoseconds thread_cpu_time()
+{
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+QString process_name(pid_t pid)
+{
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(pid));
+    if (!comm.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return QString::fromLocal8Bit(comm.readAll().trimmed());
+}
+
+}
+
+struct client_accounting::client_state {
+    struct destroy_listener {
+        wl_listener listener;
+        client_accounting* accounting;
+        wl_client* client;
+    } destroy;
+
+    client_usage usage;
+
+    struct shm_pool {
+        int64_t size;
+        // Buffers created from the pool that the client did not destroy yet.
+        size_t buffers{0};
+        bool destroyed{false};
+    };
+
+    // Pools are kept by a serial, since the id of a destroyed pool can be reused while its
+    // buffers still exist.
+    std::map<uint64_t, shm_pool> shm_pools;
+    uint64_t next_pool{0};
+
+    // Serials of the pools by their id and of the pools of shm buffers by the id of the buffer.
+    std::map<uint32_t, uint64_t> pool_serials;
+    std::map<uint32_t, uint64_t> shm_buffers;
+
+    // Dmabuf sizes by the id of the buffer.
+    std::map<uint32_t, int64_t> dmabufs;
+
+    // Sizes of the dmabuf buffers by the id of the params they are created from.
+    std::map<uint32_t, int64_t> pending_dmabufs;
+};
+
+client_accounting::client_accounting(base::protocol_logger& logger)
+    : logger{logger}
+    , loop{wl_display_get_event_loop(logger.display)}
+{
+    using base::protocol_direction;
+
+    // Registered first, so the handlers below find the client of the request.
+    logger.add(this, protocol_direction::request, nullptr, nullptr, [this](auto const& message) {
+        begin_request(message);
+    });
+
+    logger.add(this, protocol_direction::request, "wl_surface", "commit", [this](auto const&) {
+        current->usage.commits++;
+    });
+    logger.add(
+        this, protocol_direction::request, "wl_shm", "create_pool", [this](auto const& message) {
+            // The arguments are id, fd and size.
+            auto const serial = current->next_pool++;
+            current->shm_pools[serial] = {.size = message.arguments[2].i};
+            current->pool_serials[message.arguments[0].n] = serial;
+        });
+    // Pools created before the accounting started are not known.
+    logger.add(
+        this, protocol_direction::request, "wl_shm_pool", "resize", [this](auto const& message) {
+            auto it = current->pool_serials.find(wl_resource_get_id(message.resource));
+            if (it != current->pool_serials.end()) {
+                current->shm_pools.at(it->second).size = message.arguments[0].i;
+            }
+        });
+    logger.add(this,
+               protocol_direction::request,
+               "wl_shm_pool",
+               "create_buffer",
+               [this](auto const& message) {
+                   auto it = current->pool_serials.find(wl_resource_get_id(message.resource));
+                   if (it != current->pool_serials.end()) {
+                       current->shm_pools.at(it->second).buffers++;
+                       current->shm_buffers[message.arguments[0].n] = it->second;
+                   }
+               });
+    logger.add(
+        this, protocol_direction::request, "wl_shm_pool", "destroy", [this](auto const& message) {
+            // The memory of the pool stays mapped until its buffers are destroyed too.
+            auto node = current->pool_serials.extract(wl_resource_get_id(message.resource));
+            if (node.empty()) {
+                return;
+            }
+            auto it = current->shm_pools.find(node.mapped());
+            it->second.destroyed = true;
+            if (!it->second.buffers) {
+                current->shm_pools.erase(it);
+            }
+        });
+    logger.add(this,
+               protocol_direction::request,
+               "zwp_linux_buffer_params_v1",
+               "create",
+               [this](auto const& message) {
+                   auto const arguments = message.arguments;
+                   current->pending_dmabufs[wl_resource_get_id(message.resource)]
+                       = int64_t(arguments[0].i) * arguments[1].i * dmabuf_bytes_per_pixel;
+               });
+    logger.add(this,
+               protocol_direction::request,
+               "zwp_linux_buffer_params_v1",
+               "create_immed",
+               [this](auto const& message) {
+                   auto const arguments = message.arguments;
+                   current->dmabufs[arguments[0].n]
+                       = int64_t(arguments[1].i) * arguments[2].i * dmabuf_bytes_per_pixel;
+               });
+    logger.add(this,
+               protocol_direction::request,
+               "zwp_linux_buffer_params_v1",
+               "destroy",
+               [this](auto const& message) {
+                   current->pending_dmabufs.erase(wl_resource_get_id(message.resource));
+               });
+    logger.add(
+        this, protocol_direction::request, "wl_buffer", "destroy", [this](auto const& message) {
+            destroy_buffer(message);
+        });
+
+    logger.add(this,
+               protocol_direction::event,
+               "zwp_linux_buffer_params_v1",
+               "created",
+               [this](auto const& message) { handle_dmabuf_created(message); });
+
+    // Events to other clients are sent by other work, like input or presentation, which then
+    // began already.
+    logger.add(this, protocol_direction::event, nullptr, nullptr, [this](auto const& message) {
+        if (current && wl_resource_get_client(message.resource) != current->destroy.client) {
+            end_request(thread_cpu_time());
+        }
+    });
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/ClientAccounting"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+client_accounting::~client_accounting()
+{
+    logger.remove(this);
+    if (idle) {
+        wl_event_source_remove(idle);
+    }
+    for (auto& entry : clients) {
+        wl_list_remove(&entry.second->destroy.listener.link);
+    }
+}
+
+client_accounting::client_state& client_accounting::client(wl_client* client)
+{
+    auto& state = clients[client];
+    if (!state) {
+        state = std::make_unique<client_state>();
+        state->destroy.listener.notify = remove_client;
+        state->destroy.accounting = this;
+        state->destroy.client = client;
+        wl_client_add_destroy_listener(client, &state->destroy.listener);
+
+        state->usage.id = next_id++;
+        wl_client_get_credentials(client, &state->usage.pid, nullptr, nullptr);
+        state->usage.name = process_name(state->usage.pid);
+    }
+    return *state;
+}
+
+void client_accounting::remove_client(wl_listener* listener, void* /*data*/)
+{
+    client_state::destroy_listener* destroy = wl_container_of(listener, destroy, listener);
+    auto accounting = destroy->accounting;
+
+    wl_list_remove(&destroy->listener.link);
+
+    auto it = accounting->clients.find(destroy->client);
+    if (it->second.get() == accounting->current) {
+        accounting->current = nullptr;
+    }
+    accounting->clients.erase(it);
+}
+
+void client_accounting::dispatch_idle(void* data)
+{
+    // Idle sources run once after all fds of the event loop were dispatched.
+    auto accounting = static_cast<client_accounting*>(data);
+    accounting->idle = nullptr;
+    accounting->end_request(thread_cpu_time());
+}
+
+void client_accounting::end_request(std::chrono::nanoseconds now)
+{
+    if (current) {
+        current->usage.cpu_time += now - current_start;
+        current = nullptr;
+    }
+}
+
+void client_accounting::begin_request(wl_protocol_logger_message const& message)
+{
+    auto const now = thread_cpu_time();
+    end_request(now);
+
+    auto& state = client(wl_resource_get_client(message.resource));
+    state.usage.requests++;
+
+    current = &state;
+    current_start = now;
+    if (!idle) {
+        idle = wl_event_loop_add_idle(loop, dispatch_idle, this);
+    }
+}
+
+void client_accounting::handle_dmabuf_created(wl_protocol_logger_message const& message)
+{
+    // Dmabufs created without an id get one when the compositor imported them.
+    auto it = clients.find(wl_resource_get_client(message.resource));
+    if (it == clients.end()) {
+        return;
+    }
+
+    auto& state = *it->second;
+    auto node = state.pending_dmabufs.extract(wl_resource_get_id(message.resource));
+    if (node.empty()) {
+        return;
+    }
+
+    auto buffer = reinterpret_cast<wl_resource*>(message.arguments[0].o);
+    state.dmabufs[wl_resource_get_id(buffer)] = node.mapped();
+}
+
+void client_accounting::destroy_buffer(wl_protocol_logger_message const& message)
+{
+    auto const id = wl_resource_get_id(message.resource);
+    if (current->dmabufs.erase(id)) {
+        return;
+    }
+
+    auto node = current->shm_buffers.extract(id);
+    if (node.empty()) {
+        return;
+    }
+
+    auto it = current->shm_pools.find(node.mapped());
+    if (--it->second.buffers == 0 && it->second.destroyed) {
+        current->shm_pools.erase(it);
+    }
+}
+
+std::vector<client_usage> client_accounting::collect() const
+{
+    std::vector<client_usage> result;
+
+    for (auto const& [client, state] : clients) {
+        auto usage = state->usage;
+        for (auto const& [serial, pool] : state->shm_pools) {
+            usage.buffer_bytes += pool.size;
+        }
+        for (auto const& [id, bytes] : state->dmabufs) {
+            usage.buffer_bytes += bytes;
+        }
+        result.push_back(usage);
+    }
+
+    std::sort(result.begin(), result.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.cpu_time > rhs.cpu_time;
+    });
+    return result;
+}
+
+QString client_accounting::report() const
+{
+    auto text = QStringLiteral("%1 %2 %3 %4 %5 %6\n")
+                    .arg(QStringLiteral("PID"), 8)
+                    .arg(QStringLiteral("NAME"), -16)
+                    .arg(QStringLiteral("CPU ms"), 10)
+                    .arg(QStringLiteral("REQUESTS"), 10)
+                    .arg(QStringLiteral("COMMITS"), 10)
+                    .arg(QStringLiteral("BUFFERS MiB"), 12);
+
+    for (auto const& usage : collect()) {
+        text += QStringLiteral("%1 %2 %3 %4 %5 %6\n")
+                    .arg(usage.pid, 8)
+                    .arg(usage.name.left(16), -16)
+                    .arg(std::chrono::duration_cast<std::chrono::milliseconds>(usage.cpu_time)
+                             .count(),
+                         10)
+                    .arg(usage.requests, 10)
+                    .arg(usage.commits, 10)
+                    .arg(usage.buffer_bytes / 1048576., 12, 'f', 1);
+    }
+
+    return text;
+}
+
+QString client_accounting::snapshot() const
+{
+    QJsonArray array;
+
+    for (auto const& usage : collect()) {
+        array.append(QJsonObject{
+            {QStringLiteral("id"), static_cast<qint64>(usage.id)},
+            {QStringLiteral("pid"), usage.pid},
+            {QStringLiteral("name"), usage.name},
+            {QStringLiteral("cpuTimeNs"), static_cast<qint64>(usage.cpu_time.count())},
+            {QStringLiteral("requests"), static_cast<qint64>(usage.requests)},
+            {QStringLiteral("commits"), static_cast<qint64>(usage.commits)},
+            {QStringLiteral("bufferBytes"), static_cast<qint64>(usage.buffer_bytes)},
+        });
+    }
+
+    return QString::fromUtf8(QJsonDocument(array).toJson(QJsonDocument::Compact));
+}
+
+void client_accounting::reset()
+{
+    for (auto& [client, state] : clients) {
+        state->usage.cpu_time = {};
+        state->usage.requests = 0;
+        state->usage.commits = 0;
+    }
+}
+
+}
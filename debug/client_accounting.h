@@ -0,0 +1,100 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+struct wl_client;
+struct wl_event_loop;
+struct wl_event_source;
+struct wl_listener;
+struct wl_protocol_logger_message;
+
+namespace theseus_ship::base
+{
+class protocol_logger;
+}
+
+namespace theseus_ship::debug
+{
+
+struct client_usage {
+    // Unique for the lifetime of the compositor, unlike the pid.
+    uint64_t id{0};
+    pid_t pid{0};
+    QString name;
+
+    // CPU time of the main thread spent in the handlers of the requests of the client.
+    std::chrono::nanoseconds cpu_time{0};
+    uint64_t requests{0};
+    uint64_t commits{0};
+    // Size of the shm pools and estimated size of the dmabuf buffers the client holds.
+    int64_t buffer_bytes{0};
+};
+
+/**
+ * Accounts the work of the Wayland server to its clients. Each request is charged the CPU time of
+ * the main thread from its dispatch until the next request, an event to another client or the end
+ * of the event loop dispatch, whichever comes first. The time of a request thereby includes
+ * reading the following one from its client. Work of other event sources that sends no events to
+ * other clients before the end of the dispatch is still charged to the last client, and events a
+ * request sends to other clients end its time early.
+ *
+ * Shm memory is counted per pool, since buffers share the memory of their pool, until the client
+ * destroyed the pool and all buffers created from it. Dmabuf buffers are counted until the client
+ * destroys them and are estimated at four bytes per pixel.
+ *
+ * The counters are cumulative. They are available at /org/kde/KWin/ClientAccounting on D-Bus,
+ * where the kwin-top tool polls them for a live view.
+ */
+class client_accounting : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.ClientAccounting")
+
+public:
+    explicit client_accounting(base::protocol_logger& logger);
+    ~client_accounting() override;
+
+    std::vector<client_usage> collect() const;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+    /// The usage of all clients as a JSON array of objects.
+    Q_SCRIPTABLE QString snapshot() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    struct client_state;
+
+    client_state& client(wl_client* client);
+    void begin_request(wl_protocol_logger_message const& message);
+    void end_request(std::chrono::nanoseconds now);
+    void handle_dmabuf_created(wl_protocol_logger_message const& message);
+    void destroy_buffer(wl_protocol_logger_message const& message);
+
+    static void remove_client(wl_listener* listener, void* data);
+    static void dispatch_idle(void* data);
+
+    base::protocol_logger& logger;
+    wl_event_loop* loop;
+    std::map<wl_client*, std::unique_ptr<client_state>> clients;
+    uint64_t next_id{1};
+
+    // The client whose request is being dispatched.
+    client_state* current{nullptr};
+    // CPU time of the thread when the request was dispatched.
+    std::chrono::nanoseconds current_start{0};
+    wl_event_source* idle{nullptr};
+};
+
+}
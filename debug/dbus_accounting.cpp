@@ -0,0 +1,223 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "dbus_accounting.h"
+
+#include "base/config_enabled.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusReply>
+#include <QDateTime>
+#include <QEvent>
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+#include <typeinfo>
+#include <vector>
+
+// Exported by QtDBus, but only declared in a private header. Hooks can not be removed again.
+Q_DBUS_EXPORT void qDBusAddSpyHook(void (*hook)(QDBusMessage const&));
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// A call the spy hook saw is not handled when its object is unregistered in the meantime.
+constexpr size_t max_pending_calls{64};
+
+dbus_accounting* active_accounting{nullptr};
+
+bool is_object_activation(QEvent* event)
+{
+    // Method calls to an exported object are handled in the thread of the object by a private
+    // subclass of the meta call event.
+    return std::strstr(typeid(*event).name(), "QDBusActivateObjectEvent") != nullptr;
+}
+
+QString caller_name(QString const& service)
+{
+    auto const pid = QDBusConnection::sessionBus().interface()->servicePid(service);
+    if (!pid.isValid()) {
+        return service;
+    }
+
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(pid.value()));
+    if (!comm.open(QIODevice::ReadOnly)) {
+        return service;
+    }
+    return QStringLiteral("%1 (%2)").arg(service, QString::fromUtf8(comm.readAll().trimmed()));
+}
+
+double to_ms(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+QString sorted_report(std::map<QString, dbus_call_stats> const& entries)
+{
+    std::vector<std::pair<QString, dbus_call_stats>> sorted(entries.cbegin(), entries.cend());
+    std::sort(sorted.begin(), sorted.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.second.total > rhs.second.total;
+    });
+
+    QString text;
+    for (auto const& [name, stats] : sorted) {
+        text += QStringLiteral("  %1: %2 calls, %3 ms total, %4 ms average, %5 ms max\n")
+                    .arg(name)
+                    .arg(stats.count)
+                    .arg(to_ms(stats.total), 0, 'f', 2)
+                    .arg(to_ms(stats.total) / static_cast<double>(stats.count), 0, 'f', 3)
+                    .arg(to_ms(stats.max), 0, 'f', 3);
+    }
+    return text;
+}
+
+}
+
+void dbus_call_stats::add(std::chrono::nanoseconds duration)
+{
+    count++;
+    total += duration;
+    max = std::max(max, duration);
+}
+
+dbus_accounting::dbus_accounting(QStringList paths)
+    : paths{std::move(paths)}
+    , since{std::chrono::system_clock::now()}
+{
+    static bool hook_added{false};
+    if (!hook_added) {
+        qDBusAddSpyHook(&dbus_accounting::spy);
+        hook_added = true;
+    }
+    active_accounting = this;
+
+    QCoreApplication::instance()->installEventFilter(this);
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/DBusAccounting"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+dbus_accounting::~dbus_accounting()
+{
+    active_accounting = nullptr;
+}
+
+void dbus_accounting::spy(QDBusMessage const& message)
+{
+    // Called in the main thread for each incoming method call before it is handled.
+    auto self = active_accounting;
+    if (!self || message.type() != QDBusMessage::MethodCallMessage) {
+        return;
+    }
+
+    auto const path = message.path();
+    if (std::none_of(self->paths.cbegin(), self->paths.cend(), [&](auto const& tracked) {
+            return path == tracked || path.startsWith(tracked + QLatin1Char('/'));
+        })) {
+        return;
+    }
+
+    // Resolved once here instead of for every meta call event in the event filter.
+    auto object = QDBusConnection::sessionBus().objectRegisteredAt(path);
+    if (!object) {
+        return;
+    }
+
+    auto& calls = self->pending[object];
+    if (calls.size() >= max_pending_calls) {
+        calls.pop_front();
+    }
+
+    auto const interface = message.interface();
+    QString const member = interface.isEmpty()
+        ? message.member()
+        : QString(interface + QLatin1Char('.') + message.member());
+    calls.push_back({path + QLatin1Char(' ') + member, message.service()});
+}
+
+bool dbus_accounting::eventFilter(QObject* watched, QEvent* event)
+{
+    if (handling || event->type() != QEvent::MetaCall) {
+        return false;
+    }
+
+    auto it = pending.find(watched);
+    if (it == pending.end() || !is_object_activation(event)) {
+        return false;
+    }
+
+    auto const call = std::move(it->second.front());
+    it->second.pop_front();
+    if (it->second.empty()) {
+        pending.erase(it);
+    }
+
+    // Application event filters run before the receiver gets the event and there is no hook
+    // after it. The event is sent again from here, so the filters of the object still run.
+    auto const start = std::chrono::steady_clock::now();
+    handling = true;
+    QCoreApplication::sendEvent(watched, event);
+    handling = false;
+    stats[{call.method, call.caller}].add(std::chrono::steady_clock::now() - start);
+
+    return true;
+}
+
+QString dbus_accounting::report() const
+{
+    std::map<QString, dbus_call_stats> methods;
+    std::map<QString, dbus_call_stats> callers;
+
+    auto add = [](auto& sum, auto const& call_stats) {
+        sum.count += call_stats.count;
+        sum.total += call_stats.total;
+        sum.max = std::max(sum.max, call_stats.max);
+    };
+    for (auto const& [key, call_stats] : stats) {
+        add(methods[key.first], call_stats);
+        add(callers[key.second], call_stats);
+    }
+
+    // Callers are resolved only now, they may have left the bus in the meantime.
+    std::map<QString, dbus_call_stats> named_callers;
+    for (auto const& [caller, call_stats] : callers) {
+        named_callers[caller_name(caller)] = call_stats;
+    }
+
+    auto const time = QDateTime::fromMSecsSinceEpoch(
+        std::chrono::duration_cast<std::chrono::milliseconds>(since.time_since_epoch()).count());
+
+    return QStringLiteral("D-Bus calls since %1\nBy method:\n")
+               .arg(time.toString(Qt::ISODateWithMs))
+        + sorted_report(methods) + QStringLiteral("By caller:\n") + sorted_report(named_callers);
+}
+
+void dbus_accounting::reset()
+{
+    stats.clear();
+    since = std::chrono::system_clock::now();
+}
+
+std::unique_ptr<dbus_accounting> create_dbus_accounting(KConfigGroup const& config)
+{
+    auto const paths = config.readEntry("Paths",
+                                        QStringList{
+                                            QStringLiteral("/KWin"),
+                                            QStringLiteral("/Effects"),
+                                            QStringLiteral("/VirtualDesktopManager"),
+                                            QStringLiteral("/Compositor"),
+                                            QStringLiteral("/Scripting"),
+                                        });
+    return base::create_if_enabled<dbus_accounting>(config, paths);
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <utility>
+
+class QDBusMessage;
+
+namespace theseus_ship::debug
+{
+
+struct dbus_call_stats {
+    void add(std::chrono::nanoseconds duration);
+
+    uint64_t count{0};
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+};
+
+/**
+ * Counts the D-Bus method calls to the objects at the given paths and below, and measures the
+ * time their handlers take in the main thread, per method and per calling bus name. The numbers
+ * are available at /org/kde/KWin/DBusAccounting on D-Bus.
+ *
+ * The calls are seen through the spy hook of QtDBus, which is only declared in a private header.
+ * While it is installed every incoming method call passes through the main thread an additional
+ * time before being handled. The accounting is therefore only built with the
+ * KWIN_BUILD_DBUS_ACCOUNTING option.
+ *
+ * The calls are handled from the event filter of the application, so the time of their handlers
+ * can be measured. Application event filters installed later run before it and see the call only
+ * once, those installed before see it while it is being handled.
+ */
+class dbus_accounting : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.DBusAccounting")
+
+public:
+    explicit dbus_accounting(QStringList paths);
+    ~dbus_accounting() override;
+
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    static void spy(QDBusMessage const& message);
+
+    QStringList const paths;
+
+    struct pending_call {
+        QString method;
+        QString caller;
+    };
+
+    // Calls seen by the spy hook and not yet handled, by the object they are delivered to. Calls
+    // to the same object are handled in the order they arrived.
+    std::map<QObject const*, std::deque<pending_call>> pending;
+    bool handling{false};
+
+    // By method and caller.
+    std::map<std::pair<QString, QString>, dbus_call_stats> stats;
+    std::chrono::system_clock::time_point since;
+};
+
+/// Returns null if not enabled in the DBusAccounting group of kwinrc.
+std::unique_ptr<dbus_accounting> create_dbus_accounting(KConfigGroup const& config);
+
+}
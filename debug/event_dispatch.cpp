@@ -0,0 +1,258 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "event_dispatch.h"
+#include "input_fds.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDateTime>
+#include <QSocketNotifier>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <poll.h>
+#include <typeinfo>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// Input devices are opened only after the session is active.
+constexpr std::chrono::seconds libinput_search_interval{1};
+
+bool is_dbus_delivery(QEvent* event)
+{
+    // Calls and signals from the bus are delivered from the D-Bus thread by a private subclass of
+    // the meta call event.
+    return std::strstr(typeid(*event).name(), "QDBus") != nullptr;
+}
+
+}
+
+QString to_string(event_source source)
+{
+    switch (source) {
+    case event_source::wayland:
+        return QStringLiteral("Wayland");
+    case event_source::libinput:
+        return QStringLiteral("libinput");
+    case event_source::dbus:
+        return QStringLiteral("D-Bus");
+    case event_source::timer:
+        return QStringLiteral("timers");
+    case event_source::x11:
+        return QStringLiteral("X11");
+    case event_source::queued:
+        return QStringLiteral("queued calls");
+    case event_source::other:
+    case event_source::count:
+        break;
+    }
+    return QStringLiteral("other");
+}
+
+void latency_histogram::add(std::chrono::nanoseconds duration)
+{
+    auto const micros = static_cast<uint64_t>(std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+
+    // Bucket i holds durations below 2^(i+1) microseconds.
+    auto const width = static_cast<size_t>(std::bit_width(micros));
+    auto const bucket = std::min(std::max<size_t>(width, 1) - 1, bucket_count - 1);
+
+    buckets[bucket]++;
+    count++;
+    total += duration;
+    max = std::max(max, duration);
+}
+
+std::chrono::microseconds latency_histogram::percentile(double fraction) const
+{
+    auto const target = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count)));
+    uint64_t sum{0};
+
+    for (size_t bucket = 0; bucket < bucket_count; bucket++) {
+        sum += buckets[bucket];
+        if (sum >= target && sum > 0) {
+            return std::chrono::microseconds(int64_t(1) << (bucket + 1));
+        }
+    }
+
+    return {};
+}
+
+event_dispatch_monitor::event_dispatch_monitor(int wayland_fd)
+    : wayland_fd{wayland_fd}
+    , since{std::chrono::system_clock::now()}
+{
+    loop.begin = [this] { awake_time = std::chrono::steady_clock::now(); };
+    loop.end = [this] { end(); };
+
+    QCoreApplication::instance()->installEventFilter(this);
+    QCoreApplication::instance()->installNativeEventFilter(this);
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/EventDispatch"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+event_dispatch_monitor::~event_dispatch_monitor()
+{
+    QCoreApplication::instance()->removeNativeEventFilter(this);
+}
+
+bool event_dispatch_monitor::eventFilter(QObject* watched, QEvent* event)
+{
+    switch (event->type()) {
+    case QEvent::SockAct:
+        begin(classify(*static_cast<QSocketNotifier*>(watched)));
+        break;
+    case QEvent::Timer:
+    case QEvent::ZeroTimerEvent:
+        begin(event_source::timer);
+        break;
+    case QEvent::MetaCall:
+        begin(is_dbus_delivery(event) ? event_source::dbus : event_source::queued);
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+bool event_dispatch_monitor::nativeEventFilter(QByteArray const& eventType,
+                                               void* /*message*/,
+                                               qintptr* /*result*/)
+{
+    if (eventType == "xcb_generic_event_t") {
+        begin(event_source::x11);
+    }
+    return false;
+}
+
+void event_dispatch_monitor::begin(event_source source)
+{
+    if (source == event_source::wayland && input_pending()) {
+        source = event_source::libinput;
+    }
+
+    end();
+
+    auto const now = std::chrono::steady_clock::now();
+    if (loop.busy()) {
+        stats[static_cast<size_t>(source)].queue.add(now - awake_time);
+    }
+
+    dispatching = true;
+    current = source;
+    current_start = now;
+}
+
+void event_dispatch_monitor::end()
+{
+    if (!dispatching) {
+        return;
+    }
+    dispatching = false;
+    stats[static_cast<size_t>(current)].dispatch.add(std::chrono::steady_clock::now()
+                                                     - current_start);
+}
+
+event_source event_dispatch_monitor::classify(QSocketNotifier const& notifier)
+{
+    auto const fd = static_cast<int>(notifier.socket());
+    if (fd == wayland_fd) {
+        return event_source::wayland;
+    }
+
+    // The fd may have been closed and reused for another notifier.
+    if (auto it = sockets.find(fd); it != sockets.end() && it->second.notifier == &notifier) {
+        return it->second.source;
+    }
+
+    auto const source
+        = watches_input_devices(fd) ? event_source::libinput : event_source::other;
+    sockets[fd] = {&notifier, source};
+    return source;
+}
+
+bool event_dispatch_monitor::input_pending()
+{
+    if (libinput_fd < 0) {
+        auto const now = std::chrono::steady_clock::now();
+        if (now - last_libinput_search < libinput_search_interval) {
+            return false;
+        }
+        last_libinput_search = now;
+
+        libinput_fd = find_libinput_fd(wayland_fd);
+        if (libinput_fd < 0) {
+            return false;
+        }
+    }
+
+    pollfd input{.fd = libinput_fd, .events = POLLIN, .revents = 0};
+    return poll(&input, 1, 0) > 0 && (input.revents & POLLIN);
+}
+
+QString event_dispatch_monitor::report() const
+{
+    auto const time = QDateTime::fromMSecsSinceEpoch(
+        std::chrono::duration_cast<std::chrono::milliseconds>(since.time_since_epoch()).count());
+    auto text = QStringLiteral("Event loop dispatches since %1\n")
+                    .arg(time.toString(Qt::ISODateWithMs));
+
+    auto add_histogram = [&](QString const& name, latency_histogram const& histogram) {
+        text += QStringLiteral("  %1: p50 %2 us, p99 %3 us, max %4 us\n   ")
+                    .arg(name)
+                    .arg(histogram.percentile(0.5).count())
+                    .arg(histogram.percentile(0.99).count())
+                    .arg(std::chrono::duration_cast<std::chrono::microseconds>(histogram.max)
+                             .count());
+        for (size_t bucket = 0; bucket < latency_histogram::bucket_count; bucket++) {
+            if (histogram.buckets[bucket]) {
+                text += QStringLiteral(" <%1us:%2")
+                            .arg(int64_t(1) << (bucket + 1))
+                            .arg(histogram.buckets[bucket]);
+            }
+        }
+        text += QLatin1Char('\n');
+    };
+
+    for (size_t index = 0; index < stats.size(); index++) {
+        auto const& source = stats[index];
+        if (!source.dispatch.count) {
+            continue;
+        }
+
+        text += QStringLiteral("%1: %2 dispatches taking %3 ms\n")
+                    .arg(to_string(static_cast<event_source>(index)))
+                    .arg(source.dispatch.count)
+                    .arg(std::chrono::duration_cast<std::chrono::milliseconds>(
+                             source.dispatch.total)
+                             .count());
+        add_histogram(QStringLiteral("dispatch"), source.dispatch);
+        add_histogram(QStringLiteral("queue"), source.queue);
+    }
+
+    return text;
+}
+
+void event_dispatch_monitor::reset()
+{
+    stats = {};
+    since = std::chrono::system_clock::now();
+
+    // The session may have been switched and devices reopened.
+    libinput_fd = -1;
+    sockets.clear();
+}
+
+}
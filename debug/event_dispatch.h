@@ -0,0 +1,115 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "event_loop_observer.h"
+
+#include <QAbstractNativeEventFilter>
+#include <QObject>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+
+class QSocketNotifier;
+
+namespace theseus_ship::debug
+{
+
+enum class event_source {
+    wayland,
+    libinput,
+    dbus,
+    timer,
+    x11,
+    queued,
+    other,
+    count,
+};
+
+QString to_string(event_source source);
+
+/// Durations in power of two buckets of microseconds.
+struct latency_histogram {
+    static constexpr size_t bucket_count{25};
+
+    void add(std::chrono::nanoseconds duration);
+
+    /// Upper bound of the bucket the @p fraction of samples is in.
+    std::chrono::microseconds percentile(double fraction) const;
+
+    std::array<uint64_t, bucket_count> buckets{};
+    uint64_t count{0};
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+};
+
+struct event_source_stats {
+    // Time from the start of the dispatch to the next one or to the event loop blocking.
+    latency_histogram dispatch;
+    // Time from the event loop waking up to the start of the dispatch.
+    latency_histogram queue;
+};
+
+/**
+ * Records for each event loop dispatch of the main thread how long it took and how long it waited
+ * behind other dispatches of the same iteration, per source. A dispatch is considered to last
+ * until the next one starts, so work done in between, like sending posted events, is accounted
+ * to the preceding source.
+ *
+ * Sources are told apart by the socket of activated notifiers, the type of queued calls and the
+ * native events of the X11 connection. Input is dispatched together with the clients when the
+ * libinput fd is part of the Wayland event loop. Such a dispatch is accounted to libinput when
+ * input was pending at its start.
+ *
+ * The histograms are available at /org/kde/KWin/EventDispatch on D-Bus.
+ */
+class event_dispatch_monitor : public QObject, public QAbstractNativeEventFilter
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.EventDispatch")
+
+public:
+    /// The @p wayland_fd is the fd of the Wayland event loop or -1 on X11.
+    explicit event_dispatch_monitor(int wayland_fd);
+    ~event_dispatch_monitor() override;
+
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    bool nativeEventFilter(QByteArray const& eventType, void* message, qintptr* result) override;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    void begin(event_source source);
+    void end();
+    event_source classify(QSocketNotifier const& notifier);
+    bool input_pending();
+
+    int const wayland_fd;
+    int libinput_fd{-1};
+    std::chrono::steady_clock::time_point last_libinput_search;
+
+    struct notifier_source {
+        QSocketNotifier const* notifier;
+        event_source source;
+    };
+    std::map<int, notifier_source> sockets;
+
+    event_loop_observer loop;
+    std::chrono::steady_clock::time_point awake_time;
+
+    bool dispatching{false};
+    event_source current{event_source::other};
+    std::chrono::steady_clock::time_point current_start;
+
+    std::array<event_source_stats, static_cast<size_t>(event_source::count)> stats;
+    std::chrono::system_clock::time_point since;
+};
+
+}
@@ -0,0 +1,44 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "event_loop_observer.h"
+
+#include <QAbstractEventDispatcher>
+
+namespace theseus_ship::debug
+{
+
+event_loop_observer::event_loop_observer()
+{
+    auto dispatcher = QAbstractEventDispatcher::instance();
+
+    QObject::connect(dispatcher, &QAbstractEventDispatcher::awake, &qobject, [this] {
+        if (!is_busy) {
+            is_busy = true;
+            if (begin) {
+                begin();
+            }
+        }
+        if (awake) {
+            awake();
+        }
+    });
+    QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, &qobject, [this] {
+        if (!is_busy) {
+            return;
+        }
+        is_busy = false;
+        if (end) {
+            end();
+        }
+    });
+}
+
+bool event_loop_observer::busy() const
+{
+    return is_busy;
+}
+
+}
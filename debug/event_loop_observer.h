@@ -0,0 +1,42 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <functional>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Follows the iterations of the event loop of the current thread. An iteration begins when the
+ * event dispatcher wakes up and ends when it is about to block again. Until then the dispatcher
+ * announces being awake again for each further dispatch, for example when events keep arriving.
+ */
+class event_loop_observer
+{
+public:
+    event_loop_observer();
+
+    event_loop_observer(event_loop_observer const&) = delete;
+    event_loop_observer& operator=(event_loop_observer const&) = delete;
+
+    /// Whether an iteration began and did not end yet.
+    bool busy() const;
+
+    /// Called for each dispatch, the first one of an iteration included.
+    std::function<void()> awake;
+
+    /// Called at the begin and the end of each iteration.
+    std::function<void()> begin;
+    std::function<void()> end;
+
+private:
+    bool is_busy{false};
+    QObject qobject;
+};
+
+}
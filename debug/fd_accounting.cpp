@@ -0,0 +1,312 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "fd_accounting.h"
+
+#include "base/config_enabled.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <functional>
+#include <set>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+constexpr std::chrono::seconds default_interval{60};
+constexpr int default_window{10};
+
+QByteArray process_name(pid_t pid)
+{
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(pid));
+    if (!comm.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return comm.readAll().trimmed();
+}
+
+fd_kind classify_socket(int fd)
+{
+    ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0
+        || credentials.pid <= 0 || credentials.pid == getpid()) {
+        return fd_kind::socket;
+    }
+
+    auto const peer = process_name(credentials.pid);
+    if (peer == "Xwayland") {
+        return fd_kind::xwayland;
+    }
+    if (peer.startsWith("dbus-")) {
+        return fd_kind::dbus;
+    }
+    return fd_kind::socket;
+}
+
+fd_kind classify(int fd, std::set<int> const& client_fds)
+{
+    char target[256];
+    auto const path = QByteArray("/proc/self/fd/") + QByteArray::number(fd);
+    auto const size = readlink(path.constData(), target, sizeof(target) - 1);
+    if (size < 0) {
+        return fd_kind::other;
+    }
+    target[size] = '\0';
+
+    if (strncmp(target, "socket:", 7) == 0) {
+        return client_fds.count(fd) ? fd_kind::wayland_client : classify_socket(fd);
+    }
+    if (strncmp(target, "pipe:", 5) == 0) {
+        return fd_kind::pipe;
+    }
+    if (strncmp(target, "/memfd:", 7) == 0 || strncmp(target, "/dev/shm/", 9) == 0) {
+        return fd_kind::shm;
+    }
+    if (strncmp(target, "/dev/dri/", 9) == 0) {
+        return fd_kind::drm;
+    }
+    if (strstr(target, "dmabuf")) {
+        return fd_kind::dmabuf;
+    }
+    if (strstr(target, "sync_file") || strstr(target, "syncobj")) {
+        return fd_kind::sync_file;
+    }
+    if (strncmp(target, "anon_inode:", 11) == 0) {
+        // Eventfds, timerfds, signalfds, pidfds, epoll and inotify instances.
+        return fd_kind::event_loop;
+    }
+    if (target[0] == '/') {
+        return fd_kind::file;
+    }
+    return fd_kind::other;
+}
+
+wl_iterator_result count_resource(wl_resource* resource, void* data)
+{
+    auto usage = static_cast<client_fd_usage*>(data);
+    auto const interface = wl_resource_get_class(resource);
+
+    usage->resources++;
+
+    if (strcmp(interface, "wl_buffer") == 0) {
+        usage->buffers++;
+    } else if (strcmp(interface, "wl_shm_pool") == 0) {
+        usage->shm_pools++;
+    } else if (strcmp(interface, "wp_linux_drm_syncobj_timeline_v1") == 0
+               || strcmp(interface, "zwp_linux_buffer_release_v1") == 0) {
+        usage->sync_objects++;
+    }
+
+    return WL_ITERATOR_CONTINUE;
+}
+
+/// Whether each value is larger than the one before.
+bool grows_steadily(std::deque<int> const& values)
+{
+    return std::adjacent_find(values.begin(), values.end(), std::greater_equal<int>())
+        == values.end();
+}
+
+}
+
+QString to_string(fd_kind kind)
+{
+    switch (kind) {
+    case fd_kind::shm:
+        return QStringLiteral("shm");
+    case fd_kind::dmabuf:
+        return QStringLiteral("dmabuf");
+    case fd_kind::sync_file:
+        return QStringLiteral("sync file");
+    case fd_kind::drm:
+        return QStringLiteral("DRM device");
+    case fd_kind::wayland_client:
+        return QStringLiteral("Wayland client");
+    case fd_kind::xwayland:
+        return QStringLiteral("Xwayland");
+    case fd_kind::dbus:
+        return QStringLiteral("D-Bus");
+    case fd_kind::socket:
+        return QStringLiteral("other socket");
+    case fd_kind::pipe:
+        return QStringLiteral("pipe");
+    case fd_kind::event_loop:
+        return QStringLiteral("event loop");
+    case fd_kind::file:
+        return QStringLiteral("file");
+    case fd_kind::other:
+    case fd_kind::count:
+    default:
+        return QStringLiteral("other");
+    }
+}
+
+QString to_string(fd_usage const& usage)
+{
+    QStringList lines;
+
+    lines << QStringLiteral("%1 open file descriptors, limit %2").arg(usage.total).arg(usage.limit);
+    for (size_t i = 0; i < usage.kinds.size(); i++) {
+        if (usage.kinds.at(i)) {
+            lines << QStringLiteral("  %1: %2")
+                         .arg(to_string(static_cast<fd_kind>(i)))
+                         .arg(usage.kinds.at(i));
+        }
+    }
+
+    lines << QStringLiteral("%1 Wayland clients").arg(usage.clients.size());
+    for (auto const& client : usage.clients) {
+        lines << QStringLiteral("  %1 (pid %2): %3 resources, %4 buffers, %5 shm pools, "
+                                "%6 sync objects")
+                     .arg(client.name)
+                     .arg(client.pid)
+                     .arg(client.resources)
+                     .arg(client.buffers)
+                     .arg(client.shm_pools)
+                     .arg(client.sync_objects);
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+fd_accounting::fd_accounting(wl_display* display,
+                             std::chrono::milliseconds interval,
+                             size_t window)
+    : display{display}
+    , window{std::max<size_t>(window, 2)}
+{
+    QObject::connect(&timer, &QTimer::timeout, this, [this] { sample(); });
+    timer.start(interval);
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/FdAccounting"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+fd_usage fd_accounting::collect() const
+{
+    fd_usage usage;
+
+    std::set<int> client_fds;
+    wl_client* client;
+    wl_client_for_each(client, wl_display_get_client_list(display))
+    {
+        client_fd_usage client_usage;
+        wl_client_get_credentials(client, &client_usage.pid, nullptr, nullptr);
+        client_usage.name = QString::fromLocal8Bit(process_name(client_usage.pid));
+        wl_client_for_each_resource(client, count_resource, &client_usage);
+
+        client_fds.insert(wl_client_get_fd(client));
+        usage.clients.push_back(client_usage);
+    }
+
+    std::sort(usage.clients.begin(), usage.clients.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.resources > rhs.resources;
+    });
+
+    // QDir would filter the entries by the type of their targets.
+    if (auto dir = opendir("/proc/self/fd")) {
+        while (auto entry = readdir(dir)) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            auto const fd = atoi(entry->d_name);
+            if (fd == dirfd(dir)) {
+                continue;
+            }
+            usage.kinds.at(static_cast<size_t>(classify(fd, client_fds)))++;
+            usage.total++;
+        }
+        closedir(dir);
+    }
+
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        usage.limit = static_cast<int>(std::min<rlim_t>(limit.rlim_cur, INT_MAX));
+    }
+
+    return usage;
+}
+
+QString fd_accounting::report() const
+{
+    return to_string(collect());
+}
+
+void fd_accounting::sample()
+{
+    check_growth(collect());
+}
+
+void fd_accounting::check_growth(fd_usage const& usage)
+{
+    totals.push_back(usage.total);
+    if (totals.size() > window) {
+        totals.pop_front();
+    }
+
+    if (totals.size() == window && grows_steadily(totals)) {
+        qWarning().noquote() << "Open file descriptors grew in each of the last" << window
+                             << "samples, possibly leaking:\n"
+                             << to_string(usage);
+        totals.clear();
+    }
+
+    // A process can have multiple connections.
+    std::map<pid_t, std::pair<QString, int>> client_totals;
+    for (auto const& client : usage.clients) {
+        auto& total = client_totals[client.pid];
+        total.first = client.name;
+        total.second += client.buffers;
+    }
+
+    std::map<pid_t, std::deque<int>> buffers;
+    for (auto const& [pid, total] : client_totals) {
+        auto& history = buffers[pid];
+        if (auto it = client_buffers.find(pid); it != client_buffers.end()) {
+            history = std::move(it->second);
+        }
+
+        history.push_back(total.second);
+        if (history.size() > window) {
+            history.pop_front();
+        }
+
+        if (history.size() == window && grows_steadily(history)) {
+            qWarning() << "Buffers of client" << total.first << "(pid" << pid
+                       << ") grew in each of the last" << window << "samples to" << total.second;
+            history.clear();
+        }
+    }
+
+    // Histories of disconnected clients are dropped.
+    client_buffers = std::move(buffers);
+}
+
+std::unique_ptr<fd_accounting> create_fd_accounting(wl_display* display,
+                                                    KConfigGroup const& config)
+{
+    auto const interval = std::chrono::seconds(
+        std::max(1, config.readEntry("Interval", static_cast<int>(default_interval.count()))));
+    auto const window = std::max(2, config.readEntry("Window", default_window));
+
+    return base::create_if_enabled<fd_accounting>(config, display, interval, window);
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+struct wl_display;
+
+namespace theseus_ship::debug
+{
+
+enum class fd_kind {
+    shm,
+    dmabuf,
+    sync_file,
+    drm,
+    wayland_client,
+    xwayland,
+    dbus,
+    socket,
+    pipe,
+    event_loop,
+    file,
+    other,
+    count,
+};
+
+/// Resources of a Wayland client that hold file descriptors or memory on our side.
+struct client_fd_usage {
+    pid_t pid{0};
+    QString name;
+    int resources{0};
+    int buffers{0};
+    int shm_pools{0};
+    int sync_objects{0};
+};
+
+struct fd_usage {
+    std::array<int, static_cast<size_t>(fd_kind::count)> kinds{};
+    int total{0};
+    int limit{0};
+    std::vector<client_fd_usage> clients;
+};
+
+QString to_string(fd_kind kind);
+QString to_string(fd_usage const& usage);
+
+/**
+ * Accounts the open file descriptors of the compositor to subsystems and the resources holding
+ * them to Wayland clients. The counts are sampled periodically. When the total or the buffers of
+ * a client grow in each sample of the window, a warning is logged. The report is available at
+ * /org/kde/KWin/FdAccounting on D-Bus.
+ */
+class fd_accounting : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.FdAccounting")
+
+public:
+    fd_accounting(wl_display* display, std::chrono::milliseconds interval, size_t window);
+
+    fd_usage collect() const;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+
+private:
+    void sample();
+    void check_growth(fd_usage const& usage);
+
+    wl_display* display;
+    size_t const window;
+    std::deque<int> totals;
+    std::map<pid_t, std::deque<int>> client_buffers;
+    QTimer timer;
+};
+
+/// Returns null if not enabled in the FdAccounting group of kwinrc.
+std::unique_ptr<fd_accounting> create_fd_accounting(wl_display* display,
+                                                    KConfigGroup const& config);
+
+}
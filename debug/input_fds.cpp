@@ -0,0 +1,77 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "input_fds.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <algorithm>
+#include <unistd.h>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+QByteArray fd_target(int fd)
+{
+    char target[256];
+    auto const path = QByteArray("/proc/self/fd/") + QByteArray::number(fd);
+    auto const size = readlink(path.constData(), target, sizeof(target) - 1);
+    if (size < 0) {
+        return {};
+    }
+    return QByteArray(target, size);
+}
+
+/// The fds watched by the epoll instance @p fd.
+std::vector<int> epoll_targets(int fd)
+{
+    std::vector<int> targets;
+
+    if (fd_target(fd) != "anon_inode:[eventpoll]") {
+        return targets;
+    }
+
+    QFile info(QStringLiteral("/proc/self/fdinfo/%1").arg(fd));
+    if (!info.open(QIODevice::ReadOnly)) {
+        return targets;
+    }
+
+    // Each watched fd has a line "tfd: <fd> events: <mask> data: ...".
+    for (auto const& line : info.readAll().split('\n')) {
+        if (!line.startsWith("tfd:")) {
+            continue;
+        }
+        bool ok{false};
+        auto const target = line.mid(4).simplified().split(' ').value(0).toInt(&ok);
+        if (ok) {
+            targets.push_back(target);
+        }
+    }
+
+    return targets;
+}
+
+}
+
+bool watches_input_devices(int fd)
+{
+    auto const targets = epoll_targets(fd);
+    return std::any_of(targets.cbegin(), targets.cend(), [](auto target) {
+        return fd_target(target).startsWith("/dev/input/event");
+    });
+}
+
+int find_libinput_fd(int loop_fd)
+{
+    auto const targets = epoll_targets(loop_fd);
+    auto it = std::find_if(targets.cbegin(), targets.cend(), watches_input_devices);
+    return it == targets.cend() ? -1 : *it;
+}
+
+}
@@ -0,0 +1,20 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+namespace theseus_ship::debug
+{
+
+/// Whether @p fd is an epoll instance watching input devices, like the one of libinput.
+bool watches_input_devices(int fd);
+
+/**
+ * Searches the fds watched by the epoll instance @p loop_fd for the one of libinput. Returns -1
+ * when there is none, for example before the session is active and input devices are opened.
+ */
+int find_libinput_fd(int loop_fd);
+
+}
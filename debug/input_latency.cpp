@@ -0,0 +1,423 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "input_latency.h"
+
+#include "base/protocol_logger.h"
+
+#include <QDBusConnection>
+#include <algorithm>
+#include <ctime>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// Samples kept per kind of input and way of measuring.
+constexpr size_t max_samples{4096};
+
+// Longer latencies are not caused by the frame pipeline, e.g. hidden surfaces get their frame
+// callbacks late.
+constexpr int64_t max_latency_us{1000000};
+
+QString percentiles(std::deque<int64_t> const& samples)
+{
+    std::vector<int64_t> sorted(samples.cbegin(), samples.cend());
+    std::sort(sorted.begin(), sorted.end());
+
+    auto at = [&](double fraction) {
+        auto const index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+        return static_cast<double>(sorted.at(index)) / 1000.;
+    };
+
+    return QStringLiteral("%1 samples, p50 %2 ms, p90 %3 ms, p99 %4 ms, max %5 ms")
+        .arg(sorted.size())
+        .arg(at(0.5), 0, 'f', 1)
+        .arg(at(0.9), 0, 'f', 1)
+        .arg(at(0.99), 0, 'f', 1)
+        .arg(at(1.), 0, 'f', 1);
+}
+
+}
+
+/// A presentation feedback or frame callback of a commit following input. It is dropped when the
+/// resource is destroyed, also when that happens without the feedback or callback being sent.
+struct input_latency_tracer::tagged_callback {
+    tagged_callback(input_latency_tracer* tracer, wl_resource* resource, pending_input input)
+        : tracer{tracer}
+        , resource{resource}
+        , input{input}
+    {
+        destroy.notify = handle_destroy;
+        wl_resource_add_destroy_listener(resource, &destroy);
+    }
+
+    ~tagged_callback()
+    {
+        wl_list_remove(&destroy.link);
+    }
+
+    tagged_callback(tagged_callback const&) = delete;
+    tagged_callback& operator=(tagged_callback const&) = delete;
+
+    static void handle_destroy(wl_listener* listener, void* data);
+
+    wl_listener destroy;
+    input_latency_tracer* tracer;
+    wl_resource* resource;
+    pending_input input;
+};
+
+struct input_latency_tracer::client_state {
+    struct destroy_listener {
+        wl_listener listener;
+        input_latency_tracer* tracer;
+        wl_client* client;
+    } destroy;
+
+    // The oldest input event the client did not commit a reaction to yet.
+    std::optional<pending_input> input;
+
+    // Surfaces of the client with focus.
+    wl_resource* pointer_focus{nullptr};
+    wl_resource* keyboard_focus{nullptr};
+    std::map<int32_t, wl_resource*> touch_points;
+
+    // Callbacks requested since the last commit of each surface.
+    std::map<wl_resource*, surface_callbacks> surfaces;
+
+    // Presentation feedbacks and frame callbacks of commits following input.
+    std::map<wl_resource*, std::unique_ptr<tagged_callback>> tagged;
+};
+
+void input_latency_tracer::tagged_callback::handle_destroy(wl_listener* listener, void* /*data*/)
+{
+    tagged_callback* callback = wl_container_of(listener, callback, destroy);
+    auto& clients = callback->tracer->clients;
+
+    if (auto it = clients.find(wl_resource_get_client(callback->resource)); it != clients.end()) {
+        it->second->tagged.erase(callback->resource);
+    }
+}
+
+QString to_string(input_kind kind)
+{
+    switch (kind) {
+    case input_kind::pointer_motion:
+        return QStringLiteral("pointer motion");
+    case input_kind::pointer_button:
+        return QStringLiteral("pointer button");
+    case input_kind::pointer_axis:
+        return QStringLiteral("pointer axis");
+    case input_kind::key:
+        return QStringLiteral("key");
+    case input_kind::touch:
+        return QStringLiteral("touch");
+    case input_kind::count:
+        break;
+    }
+    return {};
+}
+
+input_latency_tracer::input_latency_tracer(base::protocol_logger& logger)
+    : logger{logger}
+    , presentation_clock{CLOCK_MONOTONIC}
+{
+    using base::protocol_direction;
+
+    logger.add(this,
+               protocol_direction::request,
+               "wp_presentation",
+               "feedback",
+               [this](auto const& message) {
+                   auto surface = reinterpret_cast<wl_resource*>(message.arguments[0].o);
+                   client(wl_resource_get_client(message.resource))
+                       .surfaces[surface]
+                       .feedbacks.push_back(message.arguments[1].n);
+               });
+    logger.add(
+        this, protocol_direction::request, "wl_surface", "frame", [this](auto const& message) {
+            client(wl_resource_get_client(message.resource))
+                .surfaces[message.resource]
+                .frames.push_back(message.arguments[0].n);
+        });
+    logger.add(
+        this, protocol_direction::request, "wl_surface", "destroy", [this](auto const& message) {
+            remove_surface(message);
+        });
+    logger.add(
+        this, protocol_direction::request, "wl_surface", "commit", [this](auto const& message) {
+            handle_commit(message);
+        });
+
+    auto add_event = [&](char const* interface, char const* name, auto handle) {
+        logger.add(this,
+                   protocol_direction::event,
+                   interface,
+                   name,
+                   [this, handle](auto const& message) {
+                       handle(client(wl_resource_get_client(message.resource)),
+                              message,
+                              message.arguments);
+                   });
+    };
+    auto surface_argument = [](wl_argument const& argument) {
+        return reinterpret_cast<wl_resource*>(argument.o);
+    };
+
+    // The arguments of enter events are serial and surface.
+    add_event("wl_pointer", "enter", [=](auto& state, auto const&, auto arguments) {
+        state.pointer_focus = surface_argument(arguments[1]);
+    });
+    add_event("wl_pointer", "leave", [](auto& state, auto const&, auto) {
+        state.pointer_focus = nullptr;
+    });
+    add_event("wl_keyboard", "enter", [=](auto& state, auto const&, auto arguments) {
+        state.keyboard_focus = surface_argument(arguments[1]);
+    });
+    add_event("wl_keyboard", "leave", [](auto& state, auto const&, auto) {
+        state.keyboard_focus = nullptr;
+    });
+
+    add_event("wl_pointer", "motion", [this](auto& state, auto const& message, auto arguments) {
+        add_input(message, input_kind::pointer_motion, arguments[0].u, state.pointer_focus);
+    });
+    add_event("wl_pointer", "button", [this](auto& state, auto const& message, auto arguments) {
+        add_input(message, input_kind::pointer_button, arguments[1].u, state.pointer_focus);
+    });
+    add_event("wl_pointer", "axis", [this](auto& state, auto const& message, auto arguments) {
+        add_input(message, input_kind::pointer_axis, arguments[0].u, state.pointer_focus);
+    });
+    add_event("wl_keyboard", "key", [this](auto& state, auto const& message, auto arguments) {
+        add_input(message, input_kind::key, arguments[1].u, state.keyboard_focus);
+    });
+
+    // The arguments of down are serial, time, surface, id and position.
+    add_event("wl_touch", "down", [=, this](auto& state, auto const& message, auto arguments) {
+        auto const surface = surface_argument(arguments[2]);
+        state.touch_points[arguments[3].i] = surface;
+        add_input(message, input_kind::touch, arguments[1].u, surface);
+    });
+    add_event("wl_touch", "motion", [this](auto& state, auto const& message, auto arguments) {
+        auto it = state.touch_points.find(arguments[1].i);
+        if (it != state.touch_points.end()) {
+            add_input(message, input_kind::touch, arguments[0].u, it->second);
+        }
+    });
+    add_event("wl_touch", "up", [](auto& state, auto const&, auto arguments) {
+        state.touch_points.erase(arguments[2].i);
+    });
+    add_event("wl_touch", "cancel", [](auto& state, auto const&, auto) {
+        state.touch_points.clear();
+    });
+
+    logger.add(this,
+               protocol_direction::event,
+               "wp_presentation",
+               "clock_id",
+               [this](auto const& message) { presentation_clock = message.arguments[0].u; });
+    logger.add(this,
+               protocol_direction::event,
+               "wp_presentation_feedback",
+               "presented",
+               [this](auto const& message) { handle_presented(message); });
+    logger.add(this, protocol_direction::event, "wl_callback", "done", [this](auto const& message) {
+        handle_frame_done(message);
+    });
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/InputLatency"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+input_latency_tracer::~input_latency_tracer()
+{
+    logger.remove(this);
+    for (auto& entry : clients) {
+        wl_list_remove(&entry.second->destroy.listener.link);
+    }
+    // The tagged callbacks remove their listeners when destroyed.
+    clients.clear();
+}
+
+input_latency_tracer::client_state& input_latency_tracer::client(wl_client* client)
+{
+    auto& state = clients[client];
+    if (!state) {
+        state = std::make_unique<client_state>();
+        state->destroy.listener.notify = remove_client;
+        state->destroy.tracer = this;
+        state->destroy.client = client;
+        wl_client_add_destroy_listener(client, &state->destroy.listener);
+    }
+    return *state;
+}
+
+void input_latency_tracer::remove_client(wl_listener* listener, void* /*data*/)
+{
+    client_state::destroy_listener* destroy = wl_container_of(listener, destroy, listener);
+    wl_list_remove(&destroy->listener.link);
+
+    // The resources of the client are destroyed after this, the listeners of its tagged callbacks
+    // are removed with them.
+    destroy->tracer->clients.erase(destroy->client);
+}
+
+void input_latency_tracer::add_input(wl_protocol_logger_message const& message,
+                                     input_kind kind,
+                                     uint32_t time,
+                                     wl_resource* surface)
+{
+    if (!surface) {
+        return;
+    }
+
+    auto& state = client(wl_resource_get_client(message.resource));
+    if (!state.input) {
+        state.input = pending_input{time, kind, surface};
+    }
+}
+
+void input_latency_tracer::remove_surface(wl_protocol_logger_message const& message)
+{
+    auto& state = client(wl_resource_get_client(message.resource));
+    auto const surface = message.resource;
+
+    state.surfaces.erase(surface);
+    if (state.input && state.input->surface == surface) {
+        state.input.reset();
+    }
+    if (state.pointer_focus == surface) {
+        state.pointer_focus = nullptr;
+    }
+    if (state.keyboard_focus == surface) {
+        state.keyboard_focus = nullptr;
+    }
+    std::erase_if(state.touch_points, [&](auto const& point) { return point.second == surface; });
+    std::erase_if(state.tagged,
+                  [&](auto const& callback) { return callback.second->input.surface == surface; });
+}
+
+void input_latency_tracer::handle_commit(wl_protocol_logger_message const& message)
+{
+    auto& state = client(wl_resource_get_client(message.resource));
+
+    auto node = state.surfaces.extract(message.resource);
+    if (!state.input || state.input->surface != message.resource) {
+        return;
+    }
+
+    auto const input = *state.input;
+    state.input.reset();
+
+    if (node.empty()) {
+        return;
+    }
+
+    // The presentation time is more precise than the time of the frame callback.
+    auto const& callbacks = node.mapped();
+    auto const& ids = callbacks.feedbacks.empty() ? callbacks.frames : callbacks.feedbacks;
+    auto const client = wl_resource_get_client(message.resource);
+
+    for (auto id : ids) {
+        // Ids are only looked up at the commit, when the resources still exist.
+        if (auto resource = wl_client_get_object(client, id)) {
+            state.tagged.insert_or_assign(resource,
+                                          std::make_unique<tagged_callback>(this, resource, input));
+        }
+    }
+}
+
+std::optional<input_latency_tracer::pending_input>
+input_latency_tracer::take_tagged(wl_protocol_logger_message const& message)
+{
+    auto it = clients.find(wl_resource_get_client(message.resource));
+    if (it == clients.end()) {
+        return {};
+    }
+    auto node = it->second->tagged.extract(message.resource);
+    if (node.empty()) {
+        return {};
+    }
+    return node.mapped()->input;
+}
+
+void input_latency_tracer::handle_presented(wl_protocol_logger_message const& message)
+{
+    auto const input = take_tagged(message);
+
+    // Input timestamps are taken from the monotonic clock.
+    if (!input || presentation_clock != CLOCK_MONOTONIC) {
+        return;
+    }
+
+    auto const arguments = message.arguments;
+    auto const seconds = (uint64_t(arguments[0].u) << 32) | arguments[1].u;
+    auto const present_us = seconds * 1000000 + arguments[2].u / 1000;
+    auto const present_ms = uint32_t(present_us / 1000);
+
+    add_sample(input->kind,
+               true,
+               int64_t(uint32_t(present_ms - input->time)) * 1000 + int64_t(present_us % 1000));
+}
+
+void input_latency_tracer::handle_frame_done(wl_protocol_logger_message const& message)
+{
+    // The time of the frame callback has millisecond granularity.
+    if (auto const input = take_tagged(message)) {
+        add_sample(input->kind,
+                   false,
+                   int64_t(uint32_t(message.arguments[0].u - input->time)) * 1000);
+    }
+}
+
+void input_latency_tracer::add_sample(input_kind kind, bool presented, int64_t latency_us)
+{
+    if (latency_us > max_latency_us) {
+        return;
+    }
+
+    auto& kind_samples = samples[static_cast<size_t>(kind)];
+    auto& target = presented ? kind_samples.presented : kind_samples.frame_callback;
+
+    target.push_back(latency_us);
+    if (target.size() > max_samples) {
+        target.pop_front();
+    }
+}
+
+QString input_latency_tracer::report() const
+{
+    QString text;
+
+    for (size_t index = 0; index < samples.size(); index++) {
+        auto const& kind_samples = samples[index];
+        if (kind_samples.presented.empty() && kind_samples.frame_callback.empty()) {
+            continue;
+        }
+
+        text += to_string(static_cast<input_kind>(index)) + QStringLiteral(":\n");
+        if (!kind_samples.presented.empty()) {
+            text += QStringLiteral("  presented: ") + percentiles(kind_samples.presented)
+                + QLatin1Char('\n');
+        }
+        if (!kind_samples.frame_callback.empty()) {
+            text += QStringLiteral("  frame callback: ") + percentiles(kind_samples.frame_callback)
+                + QLatin1Char('\n');
+        }
+    }
+
+    return text;
+}
+
+void input_latency_tracer::reset()
+{
+    samples = {};
+}
+
+}
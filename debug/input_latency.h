@@ -0,0 +1,114 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+struct wl_client;
+struct wl_listener;
+struct wl_protocol_logger_message;
+struct wl_resource;
+
+namespace theseus_ship::base
+{
+class protocol_logger;
+}
+
+namespace theseus_ship::debug
+{
+
+enum class input_kind {
+    pointer_motion,
+    pointer_button,
+    pointer_axis,
+    key,
+    touch,
+    count,
+};
+
+QString to_string(input_kind kind);
+
+/**
+ * Measures the latency from input events to the presentation of the frames showing their effect.
+ *
+ * The input event sent to a client carries the libinput timestamp. The next commit of the surface
+ * the input was sent to is taken as its reaction to the input. The surface is known from the last
+ * enter event of the pointer or keyboard, or from the touch down event. Commits of other surfaces,
+ * like cursor surfaces, do not count. When the client requested presentation feedback for the
+ * commit the latency is taken from its presentation time, otherwise from the time of its frame
+ * callback, which is sent once the frame was presented. Latencies are reported per kind of input
+ * at /org/kde/KWin/InputLatency on D-Bus.
+ *
+ * Only reactions of clients are measured. The cursor the compositor renders itself, which is
+ * what pointer motion moves first, is not covered.
+ */
+class input_latency_tracer : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.InputLatency")
+
+public:
+    explicit input_latency_tracer(base::protocol_logger& logger);
+    ~input_latency_tracer() override;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    struct pending_input {
+        // Milliseconds of the monotonic clock, wrapping around.
+        uint32_t time;
+        input_kind kind;
+        // The surface with focus the input was sent to.
+        wl_resource* surface;
+    };
+
+    struct surface_callbacks {
+        std::vector<uint32_t> feedbacks;
+        std::vector<uint32_t> frames;
+    };
+
+    struct tagged_callback;
+    struct client_state;
+
+    client_state& client(wl_client* client);
+    void add_input(wl_protocol_logger_message const& message,
+                   input_kind kind,
+                   uint32_t time,
+                   wl_resource* surface);
+    void remove_surface(wl_protocol_logger_message const& message);
+    void handle_commit(wl_protocol_logger_message const& message);
+    std::optional<pending_input> take_tagged(wl_protocol_logger_message const& message);
+    void handle_presented(wl_protocol_logger_message const& message);
+    void handle_frame_done(wl_protocol_logger_message const& message);
+    void add_sample(input_kind kind, bool presented, int64_t latency_us);
+
+    static void remove_client(wl_listener* listener, void* data);
+
+    base::protocol_logger& logger;
+    std::map<wl_client*, std::unique_ptr<client_state>> clients;
+
+    // The presentation clock of the Wayland server. It is updated when a client binds the
+    // presentation global.
+    uint32_t presentation_clock;
+
+    struct kind_samples {
+        std::deque<int64_t> presented;
+        std::deque<int64_t> frame_callback;
+    };
+    std::array<kind_samples, static_cast<size_t>(input_kind::count)> samples;
+};
+
+}
@@ -0,0 +1,74 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "input_watch.h"
+
+#include <QDBusConnection>
+#include <QDateTime>
+#include <algorithm>
+#include <time.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+uint32_t monotonic_msec()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint32_t>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+}
+
+input_watch::input_watch()
+    : since{std::chrono::system_clock::now()}
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/InputWatch"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+void input_watch::add_event(uint32_t time_msec)
+{
+    // The timestamps wrap around. Events from the future are seen as not having waited.
+    auto const wait = static_cast<int32_t>(monotonic_msec() - time_msec);
+    waits.add(std::chrono::milliseconds(std::max(wait, 0)));
+}
+
+QString input_watch::report()
+{
+    auto const time = QDateTime::fromMSecsSinceEpoch(
+        std::chrono::duration_cast<std::chrono::milliseconds>(since.time_since_epoch()).count());
+    auto text = QStringLiteral("Input waiting to be dispatched since %1\n")
+                    .arg(time.toString(Qt::ISODateWithMs));
+
+    text += QStringLiteral("Events from kernel timestamp to dispatch: %1, p50 %2 us, p99 %3 us, "
+                           "max %4 us\n ")
+                .arg(waits.count)
+                .arg(waits.percentile(0.5).count())
+                .arg(waits.percentile(0.99).count())
+                .arg(std::chrono::duration_cast<std::chrono::microseconds>(waits.max).count());
+    for (size_t bucket = 0; bucket < latency_histogram::bucket_count; bucket++) {
+        if (waits.buckets[bucket]) {
+            text += QStringLiteral(" <%1us:%2")
+                        .arg(int64_t(1) << (bucket + 1))
+                        .arg(waits.buckets[bucket]);
+        }
+    }
+    text += QLatin1Char('\n');
+
+    return text;
+}
+
+void input_watch::reset()
+{
+    waits = {};
+    since = std::chrono::system_clock::now();
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "event_dispatch.h"
+
+#include <como/input/keyboard.h>
+#include <como/input/platform.h>
+#include <como/input/pointer.h>
+#include <como/input/touch.h>
+
+#include <QObject>
+#include <QString>
+#include <chrono>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Measures how long input waits until the main thread dispatches it, which it only does between
+ * other work. Each event is measured from its kernel timestamp to its dispatch, with millisecond
+ * granularity. The events are handed in through add_event, see watch_input_events. The histogram
+ * is available at /org/kde/KWin/InputWatch on D-Bus.
+ *
+ * libinput is read and its events are translated on the main thread of como's input platform.
+ * Moving that onto an own thread would need support in como, this only tells how long events
+ * wait for it.
+ */
+class input_watch : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.InputWatch")
+
+public:
+    input_watch();
+
+    /// Called on dispatch of an event with the timestamp in milliseconds of the monotonic clock.
+    void add_event(uint32_t time_msec);
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report();
+    Q_SCRIPTABLE void reset();
+
+private:
+    latency_histogram waits;
+    std::chrono::system_clock::time_point since;
+};
+
+/// Hands the events of all input devices of @p platform to @p watch while it exists.
+template<typename Platform>
+void watch_input_events(input_watch& watch, Platform& platform)
+{
+    auto add = [&watch](auto const& event) { watch.add_event(event.base.time_msec); };
+
+    auto add_pointer = [&watch, add](como::input::pointer* pointer) {
+        QObject::connect(pointer, &como::input::pointer::motion, &watch, add);
+        QObject::connect(pointer, &como::input::pointer::motion_absolute, &watch, add);
+        QObject::connect(pointer, &como::input::pointer::button_changed, &watch, add);
+        QObject::connect(pointer, &como::input::pointer::axis_changed, &watch, add);
+    };
+    auto add_keyboard = [&watch, add](como::input::keyboard* keyboard) {
+        QObject::connect(keyboard, &como::input::keyboard::key_changed, &watch, add);
+    };
+    auto add_touch = [&watch, add](como::input::touch* touch) {
+        QObject::connect(touch, &como::input::touch::down, &watch, add);
+        QObject::connect(touch, &como::input::touch::motion, &watch, add);
+        QObject::connect(touch, &como::input::touch::up, &watch, add);
+    };
+
+    for (auto pointer : platform.pointers) {
+        add_pointer(pointer);
+    }
+    for (auto keyboard : platform.keyboards) {
+        add_keyboard(keyboard);
+    }
+    for (auto touch : platform.touchs) {
+        add_touch(touch);
+    }
+
+    auto platform_qobject = platform.qobject.get();
+    QObject::connect(
+        platform_qobject, &como::input::platform_qobject::pointer_added, &watch, add_pointer);
+    QObject::connect(
+        platform_qobject, &como::input::platform_qobject::keyboard_added, &watch, add_keyboard);
+    QObject::connect(
+        platform_qobject, &como::input::platform_qobject::touch_added, &watch, add_touch);
+}
+
+}
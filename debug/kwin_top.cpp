@@ -0,0 +1,233 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusReply>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+struct sample {
+    qint64 pid{0};
+    QString name;
+    qint64 cpu_time_ns{0};
+    qint64 requests{0};
+    qint64 commits{0};
+    qint64 buffer_bytes{0};
+};
+
+struct row {
+    sample current;
+    double cpu_share{0};
+    double requests_rate{0};
+    double commits_rate{0};
+};
+
+enum class sort_key {
+    cpu,
+    requests,
+    commits,
+    buffers,
+};
+
+std::optional<std::map<qint64, sample>> fetch(QString& error)
+{
+    auto const call
+        = QDBusMessage::createMethodCall(QStringLiteral("org.kde.KWin"),
+                                         QStringLiteral("/org/kde/KWin/ClientAccounting"),
+                                         QStringLiteral("org.kde.KWin.ClientAccounting"),
+                                         QStringLiteral("snapshot"));
+    QDBusReply<QString> const reply = QDBusConnection::sessionBus().call(call);
+    if (!reply.isValid()) {
+        error = reply.error().message();
+        return {};
+    }
+
+    std::map<qint64, sample> samples;
+    for (auto const& value : QJsonDocument::fromJson(reply.value().toUtf8()).array()) {
+        auto const object = value.toObject();
+        samples[object[QStringLiteral("id")].toInteger()] = {
+            .pid = object[QStringLiteral("pid")].toInteger(),
+            .name = object[QStringLiteral("name")].toString(),
+            .cpu_time_ns = object[QStringLiteral("cpuTimeNs")].toInteger(),
+            .requests = object[QStringLiteral("requests")].toInteger(),
+            .commits = object[QStringLiteral("commits")].toInteger(),
+            .buffer_bytes = object[QStringLiteral("bufferBytes")].toInteger(),
+        };
+    }
+    return samples;
+}
+
+void print(std::vector<row> const& rows, double interval)
+{
+    // Redraw in place like top when writing to a terminal.
+    if (isatty(STDOUT_FILENO)) {
+        std::cout << "\033[H\033[2J";
+    }
+
+    std::cout << qPrintable(QStringLiteral("kwin-top: %1 clients, every %2 s\n\n")
+                                .arg(rows.size())
+                                .arg(interval, 0, 'f', 1));
+    std::cout << qPrintable(QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+                                .arg(QStringLiteral("PID"), 8)
+                                .arg(QStringLiteral("NAME"), -16)
+                                .arg(QStringLiteral("CPU%"), 6)
+                                .arg(QStringLiteral("REQ/s"), 9)
+                                .arg(QStringLiteral("COMMIT/s"), 9)
+                                .arg(QStringLiteral("BUF MiB"), 9)
+                                .arg(QStringLiteral("CPU s"), 9));
+
+    for (auto const& entry : rows) {
+        std::cout << qPrintable(
+            QStringLiteral("%1 %2 %3 %4 %5 %6 %7\n")
+                .arg(entry.current.pid, 8)
+                .arg(entry.current.name.left(16), -16)
+                .arg(entry.cpu_share * 100, 6, 'f', 1)
+                .arg(entry.requests_rate, 9, 'f', 0)
+                .arg(entry.commits_rate, 9, 'f', 1)
+                .arg(entry.current.buffer_bytes / 1048576., 9, 'f', 1)
+                .arg(entry.current.cpu_time_ns / 1e9, 9, 'f', 2));
+    }
+    std::cout << std::flush;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("kwin-top"));
+
+    QCommandLineOption interval_option{
+        QStringLiteral("interval"),
+        QStringLiteral("Seconds between updates."),
+        QStringLiteral("seconds"),
+        QStringLiteral("1"),
+    };
+    QCommandLineOption count_option{
+        QStringLiteral("count"),
+        QStringLiteral("Number of updates before exiting, unlimited by default."),
+        QStringLiteral("count"),
+        QStringLiteral("0"),
+    };
+    QCommandLineOption sort_option{
+        QStringLiteral("sort"),
+        QStringLiteral("Column to sort by: cpu, requests, commits or buffers."),
+        QStringLiteral("column"),
+        QStringLiteral("cpu"),
+    };
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+        "Shows the work each Wayland client causes in kwin_wayland. Requires Enabled in the "
+        "ClientAccounting group of kwinrc."));
+    parser.addHelpOption();
+    parser.addOption(interval_option);
+    parser.addOption(count_option);
+    parser.addOption(sort_option);
+    parser.process(app);
+
+    std::map<QString, sort_key> const sort_keys{
+        {QStringLiteral("cpu"), sort_key::cpu},
+        {QStringLiteral("requests"), sort_key::requests},
+        {QStringLiteral("commits"), sort_key::commits},
+        {QStringLiteral("buffers"), sort_key::buffers},
+    };
+    auto const sort_it = sort_keys.find(parser.value(sort_option));
+    if (sort_it == sort_keys.end()) {
+        std::cerr << "Unknown sort column: " << qPrintable(parser.value(sort_option)) << std::endl;
+        return 1;
+    }
+    auto const sort = sort_it->second;
+
+    auto const interval = std::max(0.1, parser.value(interval_option).toDouble());
+    auto const count = parser.value(count_option).toInt();
+
+    std::map<qint64, sample> previous;
+    auto previous_time = std::chrono::steady_clock::now();
+    int updates{0};
+
+    auto update = [&] {
+        QString error;
+        auto samples = fetch(error);
+        if (!samples) {
+            std::cerr << "Failed to query the client accounting of kwin_wayland: "
+                      << qPrintable(error) << std::endl;
+            QCoreApplication::exit(1);
+            return;
+        }
+
+        auto const now = std::chrono::steady_clock::now();
+        auto const elapsed = std::chrono::duration<double>(now - previous_time).count();
+
+        std::vector<row> rows;
+        auto restarted = false;
+        for (auto const& [id, current] : *samples) {
+            row entry{.current = current};
+
+            // Clients that connected since the last update are measured from zero.
+            auto const it = previous.find(id);
+            auto const before = it == previous.end() ? sample{} : it->second;
+            restarted |= current.cpu_time_ns < before.cpu_time_ns
+                || current.requests < before.requests || current.commits < before.commits;
+            entry.cpu_share = (current.cpu_time_ns - before.cpu_time_ns) / 1e9 / elapsed;
+            entry.requests_rate = (current.requests - before.requests) / elapsed;
+            entry.commits_rate = (current.commits - before.commits) / elapsed;
+            rows.push_back(entry);
+        }
+
+        std::sort(rows.begin(), rows.end(), [sort](auto const& lhs, auto const& rhs) {
+            switch (sort) {
+            case sort_key::requests:
+                return lhs.requests_rate > rhs.requests_rate;
+            case sort_key::commits:
+                return lhs.commits_rate > rhs.commits_rate;
+            case sort_key::buffers:
+                return lhs.current.buffer_bytes > rhs.current.buffer_bytes;
+            case sort_key::cpu:
+                break;
+            }
+            return lhs.cpu_share > rhs.cpu_share;
+        });
+
+        previous = std::move(*samples);
+        previous_time = now;
+
+        // The first sample only provides the baseline for the rates. So does a sample after the
+        // counters were reset, since the time of the reset is unknown.
+        if (restarted) {
+            return;
+        }
+        if (updates > 0) {
+            print(rows, interval);
+        }
+
+        if (++updates > count && count > 0) {
+            QCoreApplication::quit();
+        }
+    };
+
+    QTimer timer;
+    QObject::connect(&timer, &QTimer::timeout, update);
+    timer.start(std::chrono::milliseconds(static_cast<int64_t>(interval * 1000)));
+    update();
+
+    return app.exec();
+}
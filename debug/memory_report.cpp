@@ -0,0 +1,348 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "memory_report.h"
+#include "input_fds.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <malloc.h>
+#include <set>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+/// Parses values like "1234 kB" or "12 MiB" into bytes.
+int64_t parse_size(QByteArray const& value)
+{
+    auto const parts = value.simplified().split(' ');
+    auto const number = parts.value(0).toLongLong();
+    auto const unit = parts.value(1);
+
+    if (unit == "kB" || unit == "KiB") {
+        return number * 1024;
+    }
+    if (unit == "MiB") {
+        return number * 1024 * 1024;
+    }
+    if (unit == "GiB") {
+        return number * 1024 * 1024 * 1024;
+    }
+    return number;
+}
+
+/// Calls @p func with key and value of each "key: value" line in @p path.
+template<typename Func>
+void for_each_field(QString const& path, Func&& func)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    for (auto const& line : file.readAll().split('\n')) {
+        auto const colon = line.indexOf(':');
+        if (colon > 0) {
+            func(line.left(colon), line.mid(colon + 1));
+        }
+    }
+}
+
+void collect_status(memory_usage& usage)
+{
+    for_each_field(QStringLiteral("/proc/self/status"), [&](auto const& key, auto const& value) {
+        if (key == "VmRSS") {
+            usage.rss = parse_size(value);
+        } else if (key == "RssAnon") {
+            usage.rss_anon = parse_size(value);
+        } else if (key == "RssFile") {
+            usage.rss_file = parse_size(value);
+        } else if (key == "RssShmem") {
+            usage.rss_shmem = parse_size(value);
+        }
+    });
+}
+
+enum class mapping_kind {
+    other,
+    gpu,
+    shared,
+};
+
+mapping_kind classify_mapping(QByteArray const& header)
+{
+    // The format is "start-end perms offset dev inode [path]".
+    auto const fields = header.simplified().split(' ');
+    if (fields.size() < 6) {
+        return mapping_kind::other;
+    }
+
+    auto const& perms = fields.at(1);
+    auto path = fields.mid(5).join(' ');
+
+    if (path.startsWith("/dev/dri/") || path.contains("dmabuf")) {
+        return mapping_kind::gpu;
+    }
+    if (perms.size() >= 4 && perms.at(3) == 's'
+        && (path.startsWith("/memfd:") || path.startsWith("/dev/shm/")
+            || path.endsWith("(deleted)"))) {
+        return mapping_kind::shared;
+    }
+    return mapping_kind::other;
+}
+
+void collect_mappings(memory_usage& usage)
+{
+    QFile file(QStringLiteral("/proc/self/smaps"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    auto kind = mapping_kind::other;
+
+    for (auto const& line : file.readAll().split('\n')) {
+        auto const colon = line.indexOf(':');
+        auto const space = line.indexOf(' ');
+
+        // Field lines have the colon right after the key, headers have the address range first.
+        if (colon < 0 || (space >= 0 && space < colon)) {
+            kind = classify_mapping(line);
+            continue;
+        }
+        if (kind == mapping_kind::other || line.left(colon) != "Rss") {
+            continue;
+        }
+
+        auto const size = parse_size(line.mid(colon + 1));
+        if (kind == mapping_kind::gpu) {
+            usage.gpu_mappings += size;
+        } else {
+            usage.shared_mappings += size;
+        }
+    }
+}
+
+void collect_drm_memory(memory_usage& usage)
+{
+    // Multiple file descriptors can refer to the same DRM client.
+    std::set<QByteArray> clients;
+
+    auto const fds = QDir(QStringLiteral("/proc/self/fdinfo")).entryList(QDir::Files);
+    for (auto const& fd : fds) {
+        QByteArray client;
+        int64_t resident{0};
+        int64_t total{0};
+
+        for_each_field(QStringLiteral("/proc/self/fdinfo/") + fd,
+                       [&](auto const& key, auto const& value) {
+                           if (key == "drm-client-id") {
+                               client = value.trimmed();
+                           } else if (key.startsWith("drm-resident-")) {
+                               resident += parse_size(value);
+                           } else if (key.startsWith("drm-memory-")
+                                      || key.startsWith("drm-total-")) {
+                               total += parse_size(value);
+                           }
+                       });
+
+        if (client.isEmpty() || !clients.insert(client).second) {
+            continue;
+        }
+        usage.drm_memory += resident ? resident : total;
+    }
+}
+
+void collect_xwayland(memory_usage& usage)
+{
+    auto const tasks
+        = QDir(QStringLiteral("/proc/self/task")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+
+    for (auto const& task : tasks) {
+        QFile children(QStringLiteral("/proc/self/task/%1/children").arg(task));
+        if (!children.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        for (auto const& pid : children.readAll().simplified().split(' ')) {
+            QFile comm(QStringLiteral("/proc/%1/comm").arg(QString::fromLatin1(pid)));
+            if (!comm.open(QIODevice::ReadOnly) || comm.readAll().trimmed() != "Xwayland") {
+                continue;
+            }
+
+            for_each_field(QStringLiteral("/proc/%1/status").arg(QString::fromLatin1(pid)),
+                           [&](auto const& key, auto const& value) {
+                               if (key == "VmRSS") {
+                                   usage.xwayland_rss += parse_size(value);
+                               }
+                           });
+        }
+    }
+}
+
+QString mib(int64_t bytes)
+{
+    return QStringLiteral("%1 MiB").arg(bytes / 1024. / 1024., 0, 'f', 1);
+}
+
+}
+
+memory_usage collect_memory_usage()
+{
+    memory_usage usage;
+
+    for (size_t i = 0; i < usage.heap.size(); i++) {
+        usage.heap.at(i) = memory_tag_usage_of(static_cast<memory_tag>(i));
+    }
+
+    collect_status(usage);
+    collect_mappings(usage);
+    collect_drm_memory(usage);
+    collect_xwayland(usage);
+
+    auto const info = mallinfo2();
+    usage.malloc_in_use = info.uordblks + info.hblkhd;
+    usage.malloc_free = info.fordblks;
+
+    return usage;
+}
+
+QString to_string(memory_usage const& usage)
+{
+    QStringList lines;
+
+    auto heap = [&](memory_tag tag) {
+        if (!memory_tags_enabled()) {
+            return QStringLiteral("heap not tracked");
+        }
+        auto const& tagged = usage.heap.at(static_cast<size_t>(tag));
+        return QStringLiteral("heap %1 in %2 allocations")
+            .arg(mib(tagged.bytes))
+            .arg(tagged.allocations);
+    };
+
+    lines << QStringLiteral("render: %1, GPU mappings %2, DRM memory %3")
+                 .arg(heap(memory_tag::render), mib(usage.gpu_mappings), mib(usage.drm_memory));
+    lines << QStringLiteral("input: %1").arg(heap(memory_tag::input));
+    lines << QStringLiteral("space: %1").arg(heap(memory_tag::space));
+    lines << QStringLiteral("xwayland: %1, Xwayland process %2")
+                 .arg(heap(memory_tag::xwayland), mib(usage.xwayland_rss));
+    lines << QStringLiteral("script: %1").arg(heap(memory_tag::script));
+    lines << QStringLiteral("wayland loop: %1, shared memory mappings %2")
+                 .arg(heap(memory_tag::wayland_loop), mib(usage.shared_mappings));
+    lines << QStringLiteral("untagged: %1").arg(heap(memory_tag::untagged));
+    lines << QStringLiteral("process: RSS %1 (anonymous %2, file %3, shared %4)")
+                 .arg(mib(usage.rss),
+                      mib(usage.rss_anon),
+                      mib(usage.rss_file),
+                      mib(usage.rss_shmem));
+    lines << QStringLiteral("malloc: in use %1, free but not returned %2")
+                 .arg(mib(usage.malloc_in_use), mib(usage.malloc_free));
+
+    if (!memory_tags_enabled()) {
+        lines << QStringLiteral("Set KWIN_MEMORY_TAGS to account heap memory to subsystems. This "
+                                "replaces operator new and delete, so a new/free mismatch in any "
+                                "library corrupts the heap. Only use it for debugging.");
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+memory_report::memory_report()
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/MemoryReport"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+QString memory_report::report() const
+{
+    return to_string(collect_memory_usage());
+}
+
+dispatch_memory_tags::dispatch_memory_tags(int wayland_fd)
+    : wayland_fd{wayland_fd}
+{
+    // Allocations in between iterations belong to no dispatch.
+    loop.end = [this] { scope.reset(); };
+
+    QCoreApplication::instance()->installEventFilter(this);
+    QCoreApplication::instance()->installNativeEventFilter(this);
+}
+
+dispatch_memory_tags::~dispatch_memory_tags()
+{
+    QCoreApplication::instance()->removeNativeEventFilter(this);
+}
+
+bool dispatch_memory_tags::eventFilter(QObject* watched, QEvent* event)
+{
+    switch (event->type()) {
+    case QEvent::SockAct:
+        begin(classify(*static_cast<QSocketNotifier*>(watched)));
+        break;
+    case QEvent::Timer:
+    case QEvent::ZeroTimerEvent:
+    case QEvent::MetaCall:
+        begin(memory_tag::untagged);
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+bool dispatch_memory_tags::nativeEventFilter(QByteArray const& eventType,
+                                             void* /*message*/,
+                                             qintptr* /*result*/)
+{
+    if (eventType == "xcb_generic_event_t") {
+        begin(memory_tag::xwayland);
+    }
+    return false;
+}
+
+void dispatch_memory_tags::begin(memory_tag tag)
+{
+    // The previous dispatch ends with the next one.
+    scope.reset();
+    scope.emplace(tag);
+}
+
+memory_tag dispatch_memory_tags::classify(QSocketNotifier const& notifier)
+{
+    auto const fd = static_cast<int>(notifier.socket());
+    if (fd == wayland_fd) {
+        return memory_tag::wayland_loop;
+    }
+
+    // The fd may have been closed and reused for another notifier.
+    if (auto it = sockets.find(fd); it != sockets.end() && it->second.notifier == &notifier) {
+        return it->second.tag;
+    }
+
+    auto const tag = watches_input_devices(fd) ? memory_tag::input : memory_tag::untagged;
+    sockets[fd] = {&notifier, tag};
+    return tag;
+}
+
+std::unique_ptr<dispatch_memory_tags> create_dispatch_memory_tags(int wayland_fd)
+{
+    if (!memory_tags_enabled()) {
+        return {};
+    }
+    qWarning() << "KWIN_MEMORY_TAGS is set: operator new and delete are replaced, a new/free "
+                  "mismatch in any library corrupts the heap.";
+    return std::make_unique<dispatch_memory_tags>(wayland_fd);
+}
+
+}
@@ -0,0 +1,106 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "event_loop_observer.h"
+#include "memory_tags.h"
+
+#include <QAbstractNativeEventFilter>
+#include <QObject>
+#include <QString>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+
+class QSocketNotifier;
+
+namespace theseus_ship::debug
+{
+
+/// Sizes in bytes. Mappings are counted by their resident size.
+struct memory_usage {
+    std::array<memory_tag_usage, static_cast<size_t>(memory_tag::count)> heap;
+
+    // Buffers of the GPU driver mapped into the process and memory the DRM driver accounts to
+    // our file descriptors. Both belong to render.
+    int64_t gpu_mappings{0};
+    int64_t drm_memory{0};
+
+    // Shared mappings of memfds and POSIX shm. These are mostly the pools of shm buffers the
+    // Wayland server maps for clients, but they cannot be told apart from other shared memory.
+    int64_t shared_mappings{0};
+
+    // Resident memory of Xwayland, which runs as a child process.
+    int64_t xwayland_rss{0};
+
+    int64_t rss{0};
+    int64_t rss_anon{0};
+    int64_t rss_file{0};
+    int64_t rss_shmem{0};
+
+    // Heap of malloc in use and freed but not yet returned to the system.
+    int64_t malloc_in_use{0};
+    int64_t malloc_free{0};
+};
+
+memory_usage collect_memory_usage();
+QString to_string(memory_usage const& usage);
+
+/**
+ * Reports the memory attributable to each subsystem at /org/kde/KWin/MemoryReport on D-Bus.
+ */
+class memory_report : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.MemoryReport")
+
+public:
+    memory_report();
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QString report() const;
+};
+
+/**
+ * Accounts heap allocated on the main thread at runtime to the subsystem whose events are
+ * dispatched: the Wayland event loop to wayland loop, input devices to input and the X11
+ * connection to xwayland. The sources of the Wayland event loop are dispatched inside libwayland
+ * and cannot be told apart here. Besides client requests they include libinput and DRM events
+ * with the wlroots backend, so that part of input and render is accounted to wayland loop.
+ * Everything else, like frames rendered from timers and effects, stays untagged.
+ */
+class dispatch_memory_tags : public QObject, public QAbstractNativeEventFilter
+{
+public:
+    /// The @p wayland_fd is the fd of the Wayland event loop.
+    explicit dispatch_memory_tags(int wayland_fd);
+    ~dispatch_memory_tags() override;
+
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    bool nativeEventFilter(QByteArray const& eventType, void* message, qintptr* result) override;
+
+private:
+    void begin(memory_tag tag);
+    memory_tag classify(QSocketNotifier const& notifier);
+
+    int const wayland_fd;
+
+    struct notifier_tag {
+        QSocketNotifier const* notifier;
+        memory_tag tag;
+    };
+    std::map<int, notifier_tag> sockets;
+
+    std::optional<memory_scope> scope;
+    event_loop_observer loop;
+};
+
+/// Returns null if heap allocations are not tagged.
+std::unique_ptr<dispatch_memory_tags> create_dispatch_memory_tags(int wayland_fd);
+
+}
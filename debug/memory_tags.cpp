@@ -0,0 +1,201 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "memory_tags.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// Keeps the alignment malloc() guarantees for the memory following it.
+struct alignas(alignof(std::max_align_t)) allocation_header {
+    size_t size;
+    memory_tag tag;
+};
+
+constexpr auto tag_count = static_cast<size_t>(memory_tag::count);
+
+std::atomic<int64_t> tag_bytes[tag_count];
+std::atomic<int64_t> tag_allocations[tag_count];
+
+thread_local memory_tag current_tag{memory_tag::untagged};
+
+enum class tags_state : int {
+    undecided,
+    enabled,
+    disabled,
+};
+
+std::atomic<tags_state> state{tags_state::undecided};
+
+bool enabled()
+{
+    auto current = state.load(std::memory_order_relaxed);
+    if (current != tags_state::undecided) {
+        return current == tags_state::enabled;
+    }
+
+    // The first allocation decides. Afterwards it must never change, since memory allocated in one
+    // mode can only be freed in the same one.
+    auto decided = getenv("KWIN_MEMORY_TAGS") ? tags_state::enabled : tags_state::disabled;
+    if (!state.compare_exchange_strong(current, decided)) {
+        decided = current;
+    }
+    return decided == tags_state::enabled;
+}
+
+void* allocate(size_t size)
+{
+    if (!enabled()) {
+        return malloc(size ? size : 1);
+    }
+
+    auto header = static_cast<allocation_header*>(malloc(sizeof(allocation_header) + size));
+    if (!header) {
+        return nullptr;
+    }
+
+    header->size = size;
+    header->tag = current_tag;
+
+    auto const index = static_cast<size_t>(header->tag);
+    tag_bytes[index].fetch_add(size, std::memory_order_relaxed);
+    tag_allocations[index].fetch_add(1, std::memory_order_relaxed);
+
+    return header + 1;
+}
+
+void deallocate(void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    if (!enabled()) {
+        free(ptr);
+        return;
+    }
+
+    auto header = static_cast<allocation_header*>(ptr) - 1;
+    auto const index = static_cast<size_t>(header->tag);
+    tag_bytes[index].fetch_sub(header->size, std::memory_order_relaxed);
+    tag_allocations[index].fetch_sub(1, std::memory_order_relaxed);
+
+    free(header);
+}
+
+void* allocate_or_throw(size_t size)
+{
+    if (auto ptr = allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+}
+
+char const* memory_tag_name(memory_tag tag)
+{
+    switch (tag) {
+    case memory_tag::render:
+        return "render";
+    case memory_tag::input:
+        return "input";
+    case memory_tag::space:
+        return "space";
+    case memory_tag::xwayland:
+        return "xwayland";
+    case memory_tag::script:
+        return "script";
+    case memory_tag::wayland_loop:
+        return "wayland loop";
+    case memory_tag::untagged:
+    default:
+        return "untagged";
+    }
+}
+
+bool memory_tags_enabled()
+{
+    return enabled();
+}
+
+memory_tag_usage memory_tag_usage_of(memory_tag tag)
+{
+    auto const index = static_cast<size_t>(tag);
+    return {
+        .bytes = tag_bytes[index].load(std::memory_order_relaxed),
+        .allocations = tag_allocations[index].load(std::memory_order_relaxed),
+    };
+}
+
+memory_scope::memory_scope(memory_tag tag)
+    : previous{current_tag}
+{
+    current_tag = tag;
+}
+
+memory_scope::~memory_scope()
+{
+    current_tag = previous;
+}
+
+}
+
+// Over-aligned allocations keep the default implementation, which does not interfere with these.
+void* operator new(size_t size)
+{
+    return theseus_ship::debug::allocate_or_throw(size);
+}
+
+void* operator new[](size_t size)
+{
+    return theseus_ship::debug::allocate_or_throw(size);
+}
+
+void* operator new(size_t size, std::nothrow_t const& /*tag*/) noexcept
+{
+    return theseus_ship::debug::allocate(size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const& /*tag*/) noexcept
+{
+    return theseus_ship::debug::allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    theseus_ship::debug::deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    theseus_ship::debug::deallocate(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept
+{
+    theseus_ship::debug::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, size_t /*size*/) noexcept
+{
+    theseus_ship::debug::deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::nothrow_t const& /*tag*/) noexcept
+{
+    theseus_ship::debug::deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::nothrow_t const& /*tag*/) noexcept
+{
+    theseus_ship::debug::deallocate(ptr);
+}
@@ -0,0 +1,70 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Subsystems heap allocations are accounted to. Most correspond to the members of base_mod. The
+ * wayland_loop tag covers everything dispatched from the fd of the Wayland event loop. These are
+ * the requests of Wayland clients, but with the wlroots backend also libinput and DRM events and
+ * any other source added to that loop.
+ */
+enum class memory_tag : uint8_t {
+    untagged,
+    render,
+    input,
+    space,
+    xwayland,
+    script,
+    wayland_loop,
+    count,
+};
+
+char const* memory_tag_name(memory_tag tag);
+
+struct memory_tag_usage {
+    int64_t bytes{0};
+    int64_t allocations{0};
+};
+
+/**
+ * Whether allocations through operator new are tagged. This is decided once on the first
+ * allocation of the process by the KWIN_MEMORY_TAGS environment variable. Allocations through
+ * malloc() directly, which includes the containers of Qt, are never tagged.
+ *
+ * WARNING: The executable replaces the global operator new and delete for this. With tagging
+ * enabled each allocation carries a header, so memory allocated with new and released with free()
+ * or allocated with malloc() and released with delete, for example by a mismatched library,
+ * corrupts the heap instead of going unnoticed. Only enable it for debugging.
+ */
+bool memory_tags_enabled();
+
+/// Live heap memory allocated while a scope with @p tag was active.
+memory_tag_usage memory_tag_usage_of(memory_tag tag);
+
+/**
+ * Allocations through operator new on the current thread are accounted to the tag while the
+ * scope exists. Freeing is accounted to the tag of the allocation, not the active one.
+ */
+class memory_scope
+{
+public:
+    explicit memory_scope(memory_tag tag);
+    ~memory_scope();
+
+    memory_scope(memory_scope const&) = delete;
+    memory_scope& operator=(memory_scope const&) = delete;
+
+private:
+    memory_tag previous;
+};
+
+}
@@ -0,0 +1,78 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "page_faults.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <sys/resource.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+constexpr std::chrono::seconds warning_interval{1};
+
+int64_t thread_major_faults()
+{
+    rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_majflt;
+}
+
+}
+
+page_fault_monitor::page_fault_monitor()
+    : last_faults{thread_major_faults()}
+{
+    loop.begin = [this] { busy_since = std::chrono::steady_clock::now(); };
+    loop.end = [this] { handle_iteration(); };
+}
+
+void page_fault_monitor::handle_iteration()
+{
+    iterations++;
+
+    // The thread does not fault while it sleeps, so all faults since the last iteration were
+    // taken in this one.
+    auto const faults = thread_major_faults();
+    auto const delta = faults - last_faults;
+    last_faults = faults;
+
+    if (delta <= 0) {
+        return;
+    }
+
+    faulted_iterations++;
+    total_faults += delta;
+    max_faults = std::max(max_faults, delta);
+
+    auto const now = std::chrono::steady_clock::now();
+    if (now - last_warning < warning_interval) {
+        return;
+    }
+    last_warning = now;
+
+    auto const duration
+        = std::chrono::duration_cast<std::chrono::milliseconds>(now - busy_since).count();
+    qWarning() << "Main thread took" << delta << "major page faults in an event loop iteration of"
+               << duration << "ms";
+}
+
+QString page_fault_monitor::summary() const
+{
+    return QStringLiteral("Main thread major page faults: %1 in %2 of %3 event loop iterations, "
+                          "at most %4 in one")
+        .arg(total_faults)
+        .arg(faulted_iterations)
+        .arg(iterations)
+        .arg(max_faults);
+}
+
+}
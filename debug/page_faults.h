@@ -0,0 +1,45 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "event_loop_observer.h"
+
+#include <QString>
+#include <chrono>
+#include <cstdint>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Counts the major page faults the main thread takes per event loop iteration. A major fault
+ * means that code or data of the compositor was paged out and had to be read back from disk
+ * while a frame was being produced. Iterations with faults are logged at most once per second.
+ */
+class page_fault_monitor
+{
+public:
+    page_fault_monitor();
+
+    QString summary() const;
+
+private:
+    void handle_iteration();
+
+    event_loop_observer loop;
+    std::chrono::steady_clock::time_point busy_since;
+    int64_t last_faults{0};
+
+    int64_t iterations{0};
+    int64_t faulted_iterations{0};
+    int64_t total_faults{0};
+    int64_t max_faults{0};
+
+    // Warnings are rate-limited, while being paged in the loop can fault in every iteration.
+    std::chrono::steady_clock::time_point last_warning;
+};
+
+}
@@ -0,0 +1,35 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <como/debug/perf/ftrace.h>
+
+#include <QString>
+
+/**
+ * Performance markers for code in this repository. They are written as ftrace markers when
+ * KWIN_PERF_FTRACE is set. The trace recorder wraps the ftrace markers, so they are also recorded
+ * in-process when KWIN_PERF_RECORDER is set.
+ */
+namespace theseus_ship::debug::perf
+{
+
+inline void mark(QString const& message)
+{
+    como::Perf::Ftrace::mark(message);
+}
+
+inline void begin(QString const& message, ulong ctx)
+{
+    como::Perf::Ftrace::begin(message, ctx);
+}
+
+inline void end(QString const& message, ulong ctx)
+{
+    como::Perf::Ftrace::end(message, ctx);
+}
+
+}
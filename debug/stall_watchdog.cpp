@@ -0,0 +1,281 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "stall_watchdog.h"
+
+#include "base/config_enabled.h"
+
+#include <QDBusConnection>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <semaphore.h>
+#include <string>
+#include <time.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+constexpr int max_frames{64};
+
+// The signal handler and the signal trampoline are the first frames of each capture.
+constexpr int handler_frames{2};
+
+// The main thread might be inside a system call that is not interrupted by the signal.
+constexpr std::chrono::milliseconds capture_timeout{20};
+
+struct {
+    void* frames[max_frames];
+    int count{0};
+    sem_t done;
+
+    // Each capture has its own generation. A signal of a capture that timed out may still arrive
+    // later and must not overwrite the frames of the current one.
+    std::atomic<uint64_t> requested{0};
+    std::atomic<uint64_t> served{0};
+    std::atomic<uint64_t> completed{0};
+} main_capture;
+
+int capture_signal()
+{
+    return SIGRTMIN;
+}
+
+void capture_handler(int /*signal*/)
+{
+    auto const generation = main_capture.requested.load(std::memory_order_acquire);
+    if (main_capture.served.exchange(generation, std::memory_order_relaxed) == generation) {
+        return;
+    }
+
+    auto const saved_errno = errno;
+    main_capture.count = backtrace(main_capture.frames, max_frames);
+    main_capture.completed.store(generation, std::memory_order_release);
+    sem_post(&main_capture.done);
+    errno = saved_errno;
+}
+
+int64_t steady_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+QString symbolize(char const* symbol)
+{
+    // The format is "object(mangled+offset) [address]".
+    std::string text(symbol);
+    auto const begin = text.find('(');
+    auto const end = text.find('+', begin);
+
+    if (begin == std::string::npos || end == std::string::npos || end == begin + 1) {
+        return QString::fromStdString(text);
+    }
+
+    int status{0};
+    auto const name = text.substr(begin + 1, end - begin - 1);
+    auto demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status != 0) {
+        return QString::fromStdString(text);
+    }
+
+    text.replace(begin + 1, name.size(), demangled);
+    free(demangled);
+    return QString::fromStdString(text);
+}
+
+}
+
+stall_watchdog::stall_watchdog(stall_watchdog_settings const& settings)
+    : settings{settings}
+    , main_thread{pthread_self()}
+{
+    sem_init(&main_capture.done, 0, 0);
+
+    // The first call of backtrace() loads libgcc, which must not happen in the signal handler.
+    void* frame;
+    backtrace(&frame, 1);
+
+    struct sigaction action {
+    };
+    action.sa_handler = capture_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(capture_signal(), &action, nullptr);
+
+    // The event loop may never block when events keep arriving. A stall is a single dispatch
+    // that does not return.
+    loop.awake = [this] {
+        iteration.fetch_add(1, std::memory_order_relaxed);
+        busy_since.store(steady_now(), std::memory_order_relaxed);
+    };
+    loop.end = [this] { busy_since.store(0, std::memory_order_relaxed); };
+
+    thread = std::thread([this] { run(); });
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/StallWatchdog"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+stall_watchdog::~stall_watchdog()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    stop_condition.notify_all();
+    thread.join();
+
+    // A capture that timed out may still be pending. The semaphore is kept alive for it.
+    signal(capture_signal(), SIG_IGN);
+}
+
+std::vector<stall_sample> stall_watchdog::samples() const
+{
+    std::lock_guard lock(mutex);
+    return {buffer.begin(), buffer.end()};
+}
+
+QString stall_watchdog::dump() const
+{
+    QString text;
+
+    for (auto const& sample : samples()) {
+        auto const time = QDateTime::fromMSecsSinceEpoch(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                sample.timestamp.time_since_epoch())
+                .count());
+
+        text += QStringLiteral("Event loop iteration %1 blocked for %2 ms at %3\n")
+                    .arg(sample.iteration)
+                    .arg(sample.blocked.count())
+                    .arg(time.toString(Qt::ISODateWithMs));
+
+        auto const count = static_cast<int>(sample.frames.size());
+        auto symbols = backtrace_symbols(sample.frames.data(), count);
+        if (!symbols) {
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            text += QStringLiteral("  #%1 %2\n").arg(i).arg(symbolize(symbols[i]));
+        }
+        free(symbols);
+    }
+
+    return text;
+}
+
+void stall_watchdog::clear()
+{
+    std::lock_guard lock(mutex);
+    buffer.clear();
+}
+
+void stall_watchdog::run()
+{
+    pthread_setname_np(pthread_self(), "kwin-watchdog");
+
+    auto const interval = std::max(settings.threshold / 2, std::chrono::milliseconds(1));
+    uint64_t sampled_iteration{0};
+    size_t stall_samples{0};
+
+    std::unique_lock lock(mutex);
+    while (!stop_condition.wait_for(lock, interval, [this] { return stopping; })) {
+        auto const since = busy_since.load(std::memory_order_relaxed);
+        if (!since) {
+            continue;
+        }
+
+        auto const current = iteration.load(std::memory_order_relaxed);
+        if (current != sampled_iteration) {
+            sampled_iteration = current;
+            stall_samples = 0;
+        }
+
+        auto const blocked = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::nanoseconds(steady_now() - since));
+        if (stall_samples >= settings.samples_per_stall
+            || blocked < settings.threshold * static_cast<int64_t>(stall_samples + 1)) {
+            continue;
+        }
+
+        stall_sample sample{
+            .timestamp = std::chrono::system_clock::now(),
+            .iteration = current,
+            .blocked = blocked,
+            .frames = {},
+        };
+
+        lock.unlock();
+        auto const captured = capture(sample);
+        lock.lock();
+
+        // The backtrace is only meaningful when the main thread was still in the same iteration.
+        if (!captured || busy_since.load(std::memory_order_relaxed) != since) {
+            continue;
+        }
+
+        stall_samples++;
+        buffer.push_back(std::move(sample));
+        while (buffer.size() > settings.capacity) {
+            buffer.pop_front();
+        }
+    }
+}
+
+bool stall_watchdog::capture(stall_sample& sample)
+{
+    auto const generation = main_capture.requested.fetch_add(1, std::memory_order_release) + 1;
+
+    if (pthread_kill(main_thread, capture_signal()) != 0) {
+        return false;
+    }
+
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    auto const timeout_ns = std::chrono::nanoseconds(capture_timeout).count() + deadline.tv_nsec;
+    deadline.tv_sec += timeout_ns / 1000000000;
+    deadline.tv_nsec = timeout_ns % 1000000000;
+
+    // Captures that timed out before may still complete in between.
+    while (main_capture.completed.load(std::memory_order_acquire) != generation) {
+        if (sem_timedwait(&main_capture.done, &deadline) != 0 && errno != EINTR) {
+            return false;
+        }
+    }
+
+    if (main_capture.count > handler_frames) {
+        sample.frames.assign(main_capture.frames + handler_frames,
+                             main_capture.frames + main_capture.count);
+    }
+    return true;
+}
+
+std::unique_ptr<stall_watchdog> create_stall_watchdog(KConfigGroup const& config)
+{
+    stall_watchdog_settings settings;
+    settings.threshold = std::chrono::milliseconds(
+        std::max(1, config.readEntry("Threshold", static_cast<int>(settings.threshold.count()))));
+    settings.capacity
+        = std::max(1, config.readEntry("Capacity", static_cast<int>(settings.capacity)));
+    settings.samples_per_stall = std::max(
+        1, config.readEntry("SamplesPerStall", static_cast<int>(settings.samples_per_stall)));
+
+    return base::create_if_enabled<stall_watchdog>(config, settings);
+}
+
+}
@@ -0,0 +1,90 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "event_loop_observer.h"
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+struct stall_watchdog_settings {
+    // Time the main thread must not return to the event loop before it is sampled.
+    std::chrono::milliseconds threshold{50};
+    // Number of samples kept in the ring buffer.
+    size_t capacity{64};
+    // A long stall is sampled again each threshold, up to this many times.
+    size_t samples_per_stall{8};
+};
+
+struct stall_sample {
+    std::chrono::system_clock::time_point timestamp;
+    // Number of the event loop iteration that stalled.
+    uint64_t iteration;
+    // Time since the event loop woke up for this iteration.
+    std::chrono::milliseconds blocked;
+    std::vector<void*> frames;
+};
+
+/**
+ * Watches the event loop of the main thread from a separate thread. When an iteration takes
+ * longer than the threshold the backtrace of the main thread is captured into a ring buffer.
+ * The buffer can be retrieved through D-Bus at /org/kde/KWin/StallWatchdog.
+ */
+class stall_watchdog : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.StallWatchdog")
+
+public:
+    /// Must be created on the main thread. Only one instance may exist at a time.
+    explicit stall_watchdog(stall_watchdog_settings const& settings);
+    ~stall_watchdog() override;
+
+    std::vector<stall_sample> samples() const;
+
+public Q_SLOTS:
+    /// Returns all samples with symbolized backtraces.
+    Q_SCRIPTABLE QString dump() const;
+    Q_SCRIPTABLE void clear();
+
+private:
+    void run();
+    bool capture(stall_sample& sample);
+
+    stall_watchdog_settings const settings;
+    pthread_t const main_thread;
+
+    // Written by the main thread. The start of the current dispatch is in nanoseconds of the
+    // steady clock and zero while the event loop is blocked waiting for events.
+    std::atomic<int64_t> busy_since{0};
+    std::atomic<uint64_t> iteration{0};
+    event_loop_observer loop;
+
+    mutable std::mutex mutex;
+    std::deque<stall_sample> buffer;
+
+    std::condition_variable stop_condition;
+    bool stopping{false};
+    std::thread thread;
+};
+
+/// Returns null if the watchdog is not enabled in the StallWatchdog group of kwinrc.
+std::unique_ptr<stall_watchdog> create_stall_watchdog(KConfigGroup const& config);
+
+}
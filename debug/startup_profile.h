@@ -0,0 +1,133 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "chrome_trace.h"
+#include "perf.h"
+
+#include <QDebug>
+#include <QFile>
+#include <ctime>
+
+namespace theseus_ship::debug
+{
+
+/// Time the process has been alive for, measured from its start time in /proc/self/stat.
+inline std::chrono::microseconds process_age()
+{
+    QFile file(QStringLiteral("/proc/self/stat"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    // The command name can contain spaces. Fields are counted after its closing parenthesis,
+    // where the process state is the third field and the start time the 22nd one.
+    auto const stat = file.readAll();
+    auto const fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 20) {
+        return {};
+    }
+
+    timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+
+    auto const ticks = fields.at(19).toLongLong();
+    auto const started = std::chrono::microseconds(ticks * 1000000 / sysconf(_SC_CLK_TCK));
+    auto const now = std::chrono::seconds(boot.tv_sec) + std::chrono::nanoseconds(boot.tv_nsec);
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(now) - started;
+}
+
+/**
+ * Records the duration of the steps that construct the compositor in main(). The report is only
+ * written out when a path was set, recording itself is cheap enough to always happen.
+ */
+class startup_profile
+{
+public:
+    startup_profile()
+        : start{trace_clock_now()}
+        , age_at_start{process_age()}
+    {
+    }
+
+    template<typename Func>
+    void measure(char const* name, Func&& func)
+    {
+        auto const begin = trace_clock_now();
+        perf::begin(QString::fromLatin1(name), 0);
+        func();
+        perf::end(QString::fromLatin1(name), 0);
+        add(name, begin);
+    }
+
+    /// Adds a phase that started at @p begin and ends now.
+    void add(char const* name, std::chrono::microseconds begin)
+    {
+        events.push_back({
+            .name = QString::fromLatin1(name),
+            .category = QStringLiteral("startup"),
+            .start = begin,
+            .duration = trace_clock_now() - begin,
+            .tid = gettid(),
+        });
+    }
+
+    void mark(char const* name)
+    {
+        events.push_back({
+            .name = QString::fromLatin1(name),
+            .category = QStringLiteral("startup"),
+            .start = trace_clock_now(),
+            .instant = true,
+            .tid = gettid(),
+        });
+    }
+
+    std::chrono::microseconds elapsed() const
+    {
+        return trace_clock_now() - start;
+    }
+
+    bool write() const
+    {
+        if (path.isEmpty()) {
+            return true;
+        }
+
+        auto report = events;
+
+        // Everything from exec to the first line of main(), e.g. dynamic linking and static init.
+        report.insert(report.begin(),
+                      {
+                          .name = QStringLiteral("process start"),
+                          .category = QStringLiteral("startup"),
+                          .start = start - age_at_start,
+                          .duration = age_at_start,
+                          .tid = getpid(),
+                      });
+
+        QJsonObject const metadata{
+            {QStringLiteral("process_age_at_main_us"), static_cast<qint64>(age_at_start.count())},
+            {QStringLiteral("startup_duration_us"), static_cast<qint64>(elapsed().count())},
+        };
+
+        if (!write_chrome_trace(path, report, metadata)) {
+            qWarning() << "Failed to write startup profile to" << path;
+            return false;
+        }
+        return true;
+    }
+
+    QString path;
+    std::vector<trace_event> events;
+
+private:
+    std::chrono::microseconds start;
+    std::chrono::microseconds age_at_start;
+};
+
+}
@@ -0,0 +1,349 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "trace_recorder.h"
+
+#include <como/debug/perf/ftrace.h>
+
+#include <QDBusConnection>
+#include <QDateTime>
+#include <QDebug>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
+#include <map>
+#include <string_view>
+#include <unistd.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+constexpr size_t default_capacity{16384};
+constexpr std::string_view loop_marker{"event loop"};
+
+// Shorter iterations are not recorded, they would overwrite the other markers within seconds.
+constexpr std::chrono::milliseconds long_loop_iteration{4};
+
+std::atomic<trace_recorder*> active_recorder{nullptr};
+std::atomic<uint64_t> next_recorder_id{1};
+
+struct thread_ring {
+    uint64_t owner{0};
+    trace_ring* ring{nullptr};
+};
+
+thread_local thread_ring current_ring;
+
+}
+
+trace_ring::trace_ring(pid_t tid, size_t capacity)
+    : tid{tid}
+    , slots{std::make_unique<slot[]>(capacity)}
+    , capacity{capacity}
+{
+}
+
+void trace_ring::push(trace_record_type type,
+                      char const* name,
+                      size_t size,
+                      uint64_t ctx,
+                      std::chrono::microseconds timestamp)
+{
+    trace_record record{};
+    record.timestamp = timestamp.count();
+    record.ctx = ctx;
+    record.type = type;
+
+    size = std::min(size, sizeof(record.name) - 1);
+    memcpy(record.name, name, size);
+
+    uint64_t words[record_words];
+    memcpy(words, &record, sizeof(record));
+
+    auto const index = head.load(std::memory_order_relaxed);
+    auto& target = slots[index % capacity];
+
+    target.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t word = 0; word < record_words; word++) {
+        target.words[word].store(words[word], std::memory_order_relaxed);
+    }
+    target.sequence.store(index * 2 + 2, std::memory_order_release);
+
+    head.store(index + 1, std::memory_order_release);
+}
+
+std::vector<trace_record> trace_ring::records() const
+{
+    auto const end = head.load(std::memory_order_acquire);
+    auto begin = end > capacity ? end - capacity : 0;
+
+    std::vector<trace_record> copy;
+    copy.reserve(end - begin);
+
+    for (auto index = begin; index < end; index++) {
+        auto const& source = slots[index % capacity];
+
+        // Records the writer overwrote or is writing to right now are skipped.
+        auto const sequence = source.sequence.load(std::memory_order_acquire);
+        if (sequence != index * 2 + 2) {
+            continue;
+        }
+
+        uint64_t words[record_words];
+        for (size_t word = 0; word < record_words; word++) {
+            words[word] = source.words[word].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (source.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        trace_record record;
+        memcpy(&record, words, sizeof(record));
+        copy.push_back(record);
+    }
+
+    return copy;
+}
+
+trace_recorder::trace_recorder(size_t capacity)
+    : capacity{capacity}
+    , id{next_recorder_id.fetch_add(1, std::memory_order_relaxed)}
+{
+    active_recorder = this;
+
+    // Long iterations of the main event loop frame the markers that made them long. Both records
+    // are written at the end, the begin record with the time the iteration began.
+    loop.begin = [this] {
+        loop_iteration++;
+        loop_begin = trace_clock_now();
+    };
+    loop.end = [this] {
+        auto const now = trace_clock_now();
+        if (now - loop_begin < long_loop_iteration) {
+            return;
+        }
+        auto& target = ring();
+        target.push(trace_record_type::begin,
+                    loop_marker.data(),
+                    loop_marker.size(),
+                    loop_iteration,
+                    loop_begin);
+        target.push(
+            trace_record_type::end, loop_marker.data(), loop_marker.size(), loop_iteration, now);
+    };
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/org/kde/KWin/TraceRecorder"),
+                                                 this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+trace_recorder::~trace_recorder()
+{
+    active_recorder = nullptr;
+}
+
+trace_recorder* trace_recorder::self()
+{
+    return active_recorder.load(std::memory_order_relaxed);
+}
+
+trace_ring& trace_recorder::ring()
+{
+    if (current_ring.owner != id) {
+        auto ring = std::make_unique<trace_ring>(gettid(), capacity);
+        current_ring = {.owner = id, .ring = ring.get()};
+
+        // Rings of exited threads are kept, so their records are still part of the dump.
+        std::lock_guard lock(mutex);
+        rings.push_back(std::move(ring));
+    }
+    return *current_ring.ring;
+}
+
+void trace_recorder::record(trace_record_type type, char const* name, size_t size, uint64_t ctx)
+{
+    ring().push(type, name, size, ctx, trace_clock_now());
+}
+
+void trace_recorder::record(trace_record_type type, QString const& name, uint64_t ctx)
+{
+    auto const utf8 = name.toUtf8();
+    record(type, utf8.constData(), utf8.size(), ctx);
+}
+
+std::vector<trace_event> trace_recorder::events() const
+{
+    struct thread_record {
+        trace_record record;
+        pid_t tid;
+    };
+    std::vector<thread_record> all;
+
+    {
+        std::lock_guard lock(mutex);
+        for (auto const& ring : rings) {
+            for (auto const& record : ring->records()) {
+                all.push_back({record, ring->tid});
+            }
+        }
+    }
+
+    std::stable_sort(all.begin(), all.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.record.timestamp < rhs.record.timestamp;
+    });
+
+    // Begin and end markers are paired by name and context like in ftrace post-processing.
+    std::vector<trace_event> events;
+    std::map<std::pair<std::string, uint64_t>, thread_record> open;
+
+    auto instant = [&](thread_record const& entry, QString const& name) {
+        events.push_back({
+            .name = name,
+            .category = QStringLiteral("marker"),
+            .start = std::chrono::microseconds(entry.record.timestamp),
+            .duration = {},
+            .instant = true,
+            .tid = entry.tid,
+            .args = {},
+        });
+    };
+
+    for (auto const& entry : all) {
+        auto const name = QString::fromUtf8(entry.record.name);
+        auto const key = std::make_pair(std::string(entry.record.name), entry.record.ctx);
+
+        switch (entry.record.type) {
+        case trace_record_type::mark:
+            instant(entry, name);
+            break;
+        case trace_record_type::begin:
+            open.insert_or_assign(key, entry);
+            break;
+        case trace_record_type::end: {
+            auto it = open.find(key);
+            if (it == open.end()) {
+                // The begin marker was already overwritten.
+                instant(entry, name + QStringLiteral(" (end)"));
+                break;
+            }
+            events.push_back({
+                .name = name,
+                .category = QStringLiteral("marker"),
+                .start = std::chrono::microseconds(it->second.record.timestamp),
+                .duration = std::chrono::microseconds(entry.record.timestamp
+                                                      - it->second.record.timestamp),
+                .instant = false,
+                .tid = it->second.tid,
+                .args = {{QStringLiteral("ctx"), static_cast<qint64>(entry.record.ctx)}},
+            });
+            open.erase(it);
+            break;
+        }
+        }
+    }
+
+    for (auto const& [key, entry] : open) {
+        instant(entry, QString::fromStdString(key.first) + QStringLiteral(" (begin)"));
+    }
+
+    return events;
+}
+
+QString trace_recorder::dump(QString const& path)
+{
+    auto target = path;
+    if (target.isEmpty()) {
+        target = QStringLiteral("%1/kwin-trace-%2-%3.json")
+                     .arg(QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation))
+                     .arg(getpid())
+                     .arg(QDateTime::currentMSecsSinceEpoch());
+    }
+
+    if (!write_chrome_trace(target, events())) {
+        qWarning() << "Failed to write trace to" << target;
+        return {};
+    }
+    return target;
+}
+
+std::unique_ptr<trace_recorder> create_trace_recorder()
+{
+    if (!qEnvironmentVariableIsSet("KWIN_PERF_RECORDER")) {
+        return {};
+    }
+
+    bool ok{false};
+    auto capacity = qEnvironmentVariableIntValue("KWIN_PERF_RECORDER", &ok);
+    if (!ok || capacity <= 0) {
+        capacity = default_capacity;
+    }
+
+    return std::make_unique<trace_recorder>(capacity);
+}
+
+}
+
+/*
+ * The ftrace markers of como, frame begin and end included, are recorded too. These definitions
+ * interpose the ones of the como library for the whole process and forward to them. Calls the
+ * library binds internally, for example when built with -Bsymbolic, are not seen.
+ */
+namespace como::Perf::Ftrace
+{
+
+namespace
+{
+
+template<typename Func>
+Func* library_marker(char const* symbol)
+{
+    static auto const function = reinterpret_cast<Func*>(dlsym(RTLD_NEXT, symbol));
+    return function;
+}
+
+void record(theseus_ship::debug::trace_record_type type, QString const& message, ulong ctx)
+{
+    if (auto recorder = theseus_ship::debug::trace_recorder::self()) {
+        recorder->record(type, message, ctx);
+    }
+}
+
+}
+
+void mark(QString const& message)
+{
+    using func = void(QString const&);
+    if (auto forward = library_marker<func>("_ZN4como4Perf6Ftrace4markERK7QString")) {
+        forward(message);
+    }
+    record(theseus_ship::debug::trace_record_type::mark, message, 0);
+}
+
+void begin(QString const& message, ulong ctx)
+{
+    using func = void(QString const&, ulong);
+    if (auto forward = library_marker<func>("_ZN4como4Perf6Ftrace5beginERK7QStringm")) {
+        forward(message, ctx);
+    }
+    record(theseus_ship::debug::trace_record_type::begin, message, ctx);
+}
+
+void end(QString const& message, ulong ctx)
+{
+    using func = void(QString const&, ulong);
+    if (auto forward = library_marker<func>("_ZN4como4Perf6Ftrace3endERK7QStringm")) {
+        forward(message, ctx);
+    }
+    record(theseus_ship::debug::trace_record_type::end, message, ctx);
+}
+
+}
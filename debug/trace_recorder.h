@@ -0,0 +1,121 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "chrome_trace.h"
+#include "event_loop_observer.h"
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+enum class trace_record_type : uint8_t {
+    mark,
+    begin,
+    end,
+};
+
+struct trace_record {
+    int64_t timestamp;
+    uint64_t ctx;
+    trace_record_type type;
+    char name[55];
+};
+
+/**
+ * Ring buffer written by a single thread. Old records are overwritten. Each slot is guarded by a
+ * sequence number, so readers on other threads can copy the records and drop the ones the writer
+ * overwrote in the meantime.
+ */
+class trace_ring
+{
+public:
+    trace_ring(pid_t tid, size_t capacity);
+
+    void push(trace_record_type type,
+              char const* name,
+              size_t size,
+              uint64_t ctx,
+              std::chrono::microseconds timestamp);
+    std::vector<trace_record> records() const;
+
+    pid_t const tid;
+
+private:
+    static constexpr size_t record_words{sizeof(trace_record) / sizeof(uint64_t)};
+    static_assert(sizeof(trace_record) % sizeof(uint64_t) == 0);
+
+    struct slot {
+        // Odd while the slot is written, otherwise twice the index of the record plus two.
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> words[record_words];
+    };
+
+    std::unique_ptr<slot[]> slots;
+    size_t const capacity;
+    std::atomic<uint64_t> head{0};
+};
+
+/**
+ * Records the ftrace markers of como and of theseus_ship::debug::perf into per-thread ring buffers
+ * inside the process. In contrast to ftrace this needs neither debugfs nor tracefs access. Main
+ * event loop iterations are recorded when they take longer than a few milliseconds, so they do
+ * not push the other markers out of the rings. The recorded markers are written as a Chrome trace
+ * on request.
+ */
+class trace_recorder : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWin.TraceRecorder")
+
+public:
+    /// Must be created on the main thread. Only one instance may exist at a time.
+    explicit trace_recorder(size_t capacity);
+    ~trace_recorder() override;
+
+    /// The active recorder or null when recording is disabled.
+    static trace_recorder* self();
+
+    void record(trace_record_type type, char const* name, size_t size, uint64_t ctx);
+    void record(trace_record_type type, QString const& name, uint64_t ctx);
+
+    std::vector<trace_event> events() const;
+
+public Q_SLOTS:
+    /**
+     * Writes the recorded markers as Chrome trace JSON to @p path. With an empty path a file in
+     * the runtime directory is used. Returns the path written to or an empty string on failure.
+     */
+    Q_SCRIPTABLE QString dump(QString const& path);
+
+private:
+    trace_ring& ring();
+
+    size_t const capacity;
+    // Unique per recorder, so threads never use a ring of a recorder that was destroyed.
+    uint64_t const id;
+
+    event_loop_observer loop;
+    uint64_t loop_iteration{0};
+    std::chrono::microseconds loop_begin{0};
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<trace_ring>> rings;
+};
+
+/// Returns null if the KWIN_PERF_RECORDER environment variable is not set. Its value can be the
+/// number of records kept per thread.
+std::unique_ptr<trace_recorder> create_trace_recorder();
+
+}
@@ -0,0 +1,270 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "relative_pointer_focus.h"
+
+#include "base/protocol_logger.h"
+
+#include <como/input/event.h>
+#include <como/input/platform.h>
+#include <como/input/pointer.h>
+
+#include <QObject>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace theseus_ship::input
+{
+
+/**
+ * Coalesces the pointer motion of all pointer devices to about one motion per frame of the
+ * outputs, so focus, hover and hit-testing run less often for high rate mice.
+ *
+ * The connections of the motion, button, axis and frame signals of the devices to the consumer,
+ * the pointer redirect of the platform, are cut and their events emitted by a proxy device
+ * instead. Other receivers of the device signals stay connected. The proxy is added to the
+ * platform only while a real pointer device exists, so the platform still sees when there is no
+ * pointer, like in tablet mode.
+ *
+ * The first motion after an idle refresh interval passes through at once. Following motion is
+ * summed up, or for absolute motion the last position is kept. It is emitted after the next frame,
+ * which is seen from the frame callbacks the compositor sends to clients when it repaints. This
+ * happens from the event loop, not while the callbacks are sent. When nothing repaints, pending
+ * motion is emitted one refresh interval of the fastest output after the last one. Pending motion
+ * is emitted before buttons and axis events, so they act on the current position. Pending motion
+ * of a removed device is dropped.
+ *
+ * Motion passes through at full rate while the client with pointer focus requested a relative
+ * pointer, since it would otherwise receive the relative motion at the interval too.
+ *
+ * The devices cannot be connected back to the consumer, so coalescing stays active until exit.
+ */
+template<typename Platform>
+class motion_coalescer
+{
+public:
+    /**
+     * Must be created after the @p consumer connected to the devices. The @p frame_interval is the
+     * shortest refresh interval of the outputs.
+     */
+    motion_coalescer(Platform& platform,
+                     QObject* consumer,
+                     base::protocol_logger& logger,
+                     std::function<std::chrono::nanoseconds()> frame_interval)
+        : platform{platform}
+        , consumer{consumer}
+        , frame_interval{std::move(frame_interval)}
+        , logger{logger}
+        , relative_focus{logger}
+        , proxy{std::make_unique<como::input::pointer>()}
+    {
+        timer.setSingleShot(true);
+        timer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&timer, &QTimer::timeout, &qobject, [this] { flush(); });
+
+        // Frame callbacks are sent when the frames of the outputs were presented.
+        logger.add(this,
+                   base::protocol_direction::event,
+                   "wl_callback",
+                   "done",
+                   [this](auto const& /*message*/) { handle_frame(); });
+
+        // Copied, since the proxy is added to the list.
+        auto const pointers = platform.pointers;
+        for (auto pointer : pointers) {
+            add_pointer(pointer);
+        }
+        QObject::connect(platform.qobject.get(),
+                         &como::input::platform_qobject::pointer_added,
+                         &qobject,
+                         [this](auto pointer) { add_pointer(pointer); });
+    }
+
+    ~motion_coalescer()
+    {
+        logger.remove(this);
+        flush();
+        if (!devices.empty()) {
+            como::input::platform_remove_pointer(proxy.get(), platform);
+        }
+    }
+
+private:
+    void add_pointer(como::input::pointer* pointer)
+    {
+        if (pointer == proxy.get()) {
+            return;
+        }
+
+        QObject::disconnect(pointer, &como::input::pointer::motion, consumer, nullptr);
+        QObject::disconnect(pointer, &como::input::pointer::motion_absolute, consumer, nullptr);
+        QObject::disconnect(pointer, &como::input::pointer::button_changed, consumer, nullptr);
+        QObject::disconnect(pointer, &como::input::pointer::axis_changed, consumer, nullptr);
+        QObject::disconnect(pointer, &como::input::pointer::frame, consumer, nullptr);
+
+        QObject::connect(pointer,
+                         &como::input::pointer::motion,
+                         &qobject,
+                         [this](auto const& event) { add_motion(event); });
+        QObject::connect(pointer,
+                         &como::input::pointer::motion_absolute,
+                         &qobject,
+                         [this](auto const& event) { add_motion_absolute(event); });
+        QObject::connect(pointer,
+                         &como::input::pointer::button_changed,
+                         &qobject,
+                         [this](auto const& event) {
+                             flush();
+                             Q_EMIT proxy->button_changed(event);
+                         });
+        QObject::connect(pointer,
+                         &como::input::pointer::axis_changed,
+                         &qobject,
+                         [this](auto const& event) {
+                             flush();
+                             Q_EMIT proxy->axis_changed(event);
+                         });
+        QObject::connect(pointer, &como::input::pointer::frame, &qobject, [this] {
+            // A frame ending pending motion is sent with it.
+            if (motion || motion_absolute) {
+                pending_frame = true;
+                return;
+            }
+            Q_EMIT proxy->frame();
+        });
+        QObject::connect(pointer, &QObject::destroyed, &qobject, [this, pointer] {
+            remove_pointer(pointer);
+        });
+
+        devices.push_back(pointer);
+        if (devices.size() == 1) {
+            como::input::platform_add_pointer(proxy.get(), platform);
+        }
+    }
+
+    void remove_pointer(como::input::pointer* pointer)
+    {
+        // The device is being destroyed, so its events must not be emitted anymore.
+        if (motion && motion->base.dev == pointer) {
+            motion.reset();
+        }
+        if (motion_absolute && motion_absolute->base.dev == pointer) {
+            motion_absolute.reset();
+        }
+        if (!motion && !motion_absolute) {
+            timer.stop();
+            pending_frame = false;
+        }
+
+        std::erase(devices, pointer);
+        if (devices.empty()) {
+            como::input::platform_remove_pointer(proxy.get(), platform);
+        }
+    }
+
+    void add_motion(como::input::motion_event const& event)
+    {
+        if (motion_absolute) {
+            flush();
+        }
+
+        if (motion) {
+            motion->delta += event.delta;
+            motion->unaccel_delta += event.unaccel_delta;
+            motion->base = event.base;
+        } else {
+            motion = event;
+        }
+        schedule();
+    }
+
+    void add_motion_absolute(como::input::motion_absolute_event const& event)
+    {
+        if (motion) {
+            flush();
+        }
+
+        motion_absolute = event;
+        schedule();
+    }
+
+    void handle_frame()
+    {
+        // Emitting motion runs focus and hit-testing, which must not happen while the compositor
+        // sends frame callbacks.
+        if (motion || motion_absolute) {
+            timer.start(0);
+        }
+    }
+
+    void schedule()
+    {
+        if (relative_focus.active()) {
+            flush();
+            return;
+        }
+        if (timer.isActive()) {
+            return;
+        }
+
+        auto const next = last_flush + frame_interval();
+        auto const now = std::chrono::steady_clock::now();
+        if (next <= now) {
+            flush();
+            return;
+        }
+        timer.start(std::chrono::ceil<std::chrono::milliseconds>(next - now));
+    }
+
+    void flush()
+    {
+        timer.stop();
+
+        if (motion) {
+            auto const event = *motion;
+            motion.reset();
+            Q_EMIT proxy->motion(event);
+        } else if (motion_absolute) {
+            auto const event = *motion_absolute;
+            motion_absolute.reset();
+            Q_EMIT proxy->motion_absolute(event);
+        } else {
+            return;
+        }
+
+        last_flush = std::chrono::steady_clock::now();
+
+        if (pending_frame) {
+            pending_frame = false;
+            Q_EMIT proxy->frame();
+        }
+    }
+
+    Platform& platform;
+    QObject* consumer;
+    std::function<std::chrono::nanoseconds()> frame_interval;
+    base::protocol_logger& logger;
+    relative_pointer_focus relative_focus;
+    std::unique_ptr<como::input::pointer> proxy;
+
+    // The real pointer devices.
+    std::vector<como::input::pointer*> devices;
+
+    std::optional<como::input::motion_event> motion;
+    std::optional<como::input::motion_absolute_event> motion_absolute;
+    bool pending_frame{false};
+    std::chrono::steady_clock::time_point last_flush;
+
+    QTimer timer;
+    QObject qobject;
+};
+
+}
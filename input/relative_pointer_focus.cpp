@@ -0,0 +1,82 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "relative_pointer_focus.h"
+
+#include "base/protocol_logger.h"
+
+#include <wayland-server-core.h>
+
+namespace theseus_ship::input
+{
+
+struct relative_pointer_focus::destroy_listener {
+    wl_listener listener;
+    relative_pointer_focus* focus;
+    wl_client* client;
+};
+
+relative_pointer_focus::relative_pointer_focus(base::protocol_logger& logger)
+    : logger{logger}
+{
+    logger.add(this,
+               base::protocol_direction::request,
+               "zwp_relative_pointer_manager_v1",
+               "get_relative_pointer",
+               [this](auto const& message) {
+                   add_client(wl_resource_get_client(message.resource));
+               });
+    logger.add(
+        this, base::protocol_direction::event, "wl_pointer", "enter", [this](auto const& message) {
+            focus = wl_resource_get_client(message.resource);
+        });
+    logger.add(
+        this, base::protocol_direction::event, "wl_pointer", "leave", [this](auto const& message) {
+            if (focus == wl_resource_get_client(message.resource)) {
+                focus = nullptr;
+            }
+        });
+}
+
+relative_pointer_focus::~relative_pointer_focus()
+{
+    logger.remove(this);
+    for (auto& entry : clients) {
+        wl_list_remove(&entry.second->listener.link);
+    }
+}
+
+bool relative_pointer_focus::active() const
+{
+    return focus && clients.contains(focus);
+}
+
+void relative_pointer_focus::add_client(wl_client* client)
+{
+    auto& listener = clients[client];
+    if (listener) {
+        return;
+    }
+
+    listener = std::make_unique<destroy_listener>();
+    listener->listener.notify = remove_client;
+    listener->focus = this;
+    listener->client = client;
+    wl_client_add_destroy_listener(client, &listener->listener);
+}
+
+void relative_pointer_focus::remove_client(wl_listener* listener, void* /*data*/)
+{
+    destroy_listener* destroy = wl_container_of(listener, destroy, listener);
+    auto focus = destroy->focus;
+
+    wl_list_remove(&destroy->listener.link);
+    if (focus->focus == destroy->client) {
+        focus->focus = nullptr;
+    }
+    focus->clients.erase(destroy->client);
+}
+
+}
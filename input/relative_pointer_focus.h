@@ -0,0 +1,46 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <map>
+#include <memory>
+
+struct wl_client;
+struct wl_listener;
+
+namespace theseus_ship::base
+{
+class protocol_logger;
+}
+
+namespace theseus_ship::input
+{
+
+/**
+ * Follows from the protocol messages which clients requested relative pointers and which client
+ * has pointer focus.
+ */
+class relative_pointer_focus
+{
+public:
+    explicit relative_pointer_focus(base::protocol_logger& logger);
+    ~relative_pointer_focus();
+
+    /// Whether the client with pointer focus requested a relative pointer.
+    bool active() const;
+
+private:
+    struct destroy_listener;
+
+    void add_client(wl_client* client);
+    static void remove_client(wl_listener* listener, void* data);
+
+    base::protocol_logger& logger;
+    std::map<wl_client*, std::unique_ptr<destroy_listener>> clients;
+    wl_client* focus{nullptr};
+};
+
+}
@@ -0,0 +1,50 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfig>
+#include <KCoreConfigSkeleton>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QStringList>
+
+namespace theseus_ship
+{
+
+/**
+ * The groups of kwinrc the items of @p skeletons are stored in. Skeletons of other files are
+ * ignored.
+ */
+inline QStringList kwinrcGroups(QList<KCoreConfigSkeleton*> const& skeletons)
+{
+    QStringList groups;
+    for (auto skeleton : skeletons) {
+        if (!skeleton || skeleton->config()->name() != QLatin1String("kwinrc")) {
+            continue;
+        }
+        for (auto item : skeleton->items()) {
+            if (!groups.contains(item->group())) {
+                groups << item->group();
+            }
+        }
+    }
+    return groups;
+}
+
+/**
+ * Tells all kwin instances that @p groups of kwinrc were saved. In contrast to the reloadConfig
+ * signal only subsystems reading groups whose content actually changed are reloaded.
+ */
+inline void reloadConfigGroups(QStringList const& groups)
+{
+    auto message = QDBusMessage::createSignal(QStringLiteral("/KWin"),
+                                              QStringLiteral("org.kde.KWin"),
+                                              QStringLiteral("reloadConfigGroups"));
+    message << groups;
+    QDBusConnection::sessionBus().send(message);
+}
+
+}
@@ -22,6 +22,7 @@
 
 #include "kwindecorationdata.h"
 #include "kwindecorationsettings.h"
+#include "reloadconfig.h"
 
 K_PLUGIN_FACTORY_WITH_JSON(KCMKWinDecorationFactory,
                            "kcm_kwindecoration.json",
@@ -169,9 +170,7 @@ void KCMKWinDecoration::save()
     KQuickManagedConfigModule::save();
 
     // Send a signal to all kwin instances
-    QDBusMessage message = QDBusMessage::createSignal(
-        QStringLiteral("/KWin"), QStringLiteral("org.kde.KWin"), QStringLiteral("reloadConfig"));
-    QDBusConnection::sessionBus().send(message);
+    theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({settings()}));
 }
 
 void KCMKWinDecoration::defaults()
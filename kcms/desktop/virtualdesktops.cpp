@@ -8,6 +8,7 @@
 #include "virtualdesktops.h"
 #include "animationsmodel.h"
 #include "desktopsmodel.h"
+#include "reloadconfig.h"
 #include "virtualdesktopsdata.h"
 #include "virtualdesktopssettings.h"
 
@@ -83,9 +84,8 @@ void VirtualDesktops::save()
     m_data->desktopsModel()->syncWithServer();
     m_data->animationsModel()->save();
 
-    QDBusMessage message = QDBusMessage::createSignal(
-        QStringLiteral("/KWin"), QStringLiteral("org.kde.KWin"), QStringLiteral("reloadConfig"));
-    QDBusConnection::sessionBus().send(message);
+    // The animations are enabled in the Plugins group.
+    reloadConfigGroups(kwinrcGroups({m_data->settings()}) << QStringLiteral("Plugins"));
 }
 
 void VirtualDesktops::defaults()
@@ -20,6 +20,7 @@
 #include "kwinoptions_settings.h"
 #include "kwinoptionsdata.h"
 #include "mouse.h"
+#include "reloadconfig.h"
 #include "windows.h"
 
 K_PLUGIN_CLASS_WITH_JSON(KWinOptions, "kcm_kwinoptions.json")
@@ -125,8 +126,7 @@ void KWinOptions::save()
     mAdvanced->save();
 
     // Send signal to all kwin instances
-    QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-    QDBusConnection::sessionBus().send(message);
+    theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({mSettings}));
 }
 
 void KWinOptions::defaults()
@@ -207,8 +207,7 @@ void KActionsOptions::save()
 
     setNeedsSave(false);
     // Send signal to all kwin instances
-    QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-    QDBusConnection::sessionBus().send(message);
+    theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({mSettings}));
 }
 
 void KActionsOptions::defaults()
@@ -8,6 +8,7 @@
 #include "mouse.h"
 
 #include "kwinoptions_settings.h"
+#include "reloadconfig.h"
 
 #include <KConfigDialogManager>
 #include <QDBusConnection>
@@ -50,8 +51,7 @@ void KTitleBarActionsConfig::save()
 
     if (standAlone) {
         // Send signal to all kwin instances
-        QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-        QDBusConnection::sessionBus().send(message);
+        theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({m_settings}));
     }
 }
 
@@ -79,7 +79,6 @@ void KWindowActionsConfig::save()
 
     if (standAlone) {
         // Send signal to all kwin instances
-        QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-        QDBusConnection::sessionBus().send(message);
+        theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({m_settings}));
     }
 }
@@ -24,6 +24,7 @@
 #include <KWindowSystem>
 
 #include "kwinoptions_settings.h"
+#include "reloadconfig.h"
 #include "windows.h"
 #include <kwin_effects_interface.h>
 
@@ -248,8 +249,7 @@ void KFocusConfig::save(void)
 
     if (standAlone) {
         // Send signal to all kwin instances
-        QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-        QDBusConnection::sessionBus().send(message);
+        theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({m_settings}));
     }
 }
 
@@ -309,8 +309,7 @@ void KAdvancedConfig::save(void)
 
     if (standAlone) {
         // Send signal to all kwin instances
-        QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-        QDBusConnection::sessionBus().send(message);
+        theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({m_settings}));
     }
 }
 
@@ -342,7 +341,6 @@ void KMovingConfig::save(void)
 
     if (standAlone) {
         // Send signal to all kwin instances
-        QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-        QDBusConnection::sessionBus().send(message);
+        theseus_ship::reloadConfigGroups(theseus_ship::kwinrcGroups({m_settings}));
     }
 }
@@ -23,6 +23,7 @@ SPDX-License-Identifier: GPL-2.0-or-later
 #include "kwinscreenedgeeffectsettings.h"
 #include "kwinscreenedgescriptsettings.h"
 #include "kwinscreenedgesettings.h"
+#include "reloadconfig.h"
 
 K_PLUGIN_FACTORY_WITH_JSON(KWinScreenEdgesConfigFactory,
                            "kcm_kwinscreenedges.json",
@@ -102,8 +103,14 @@ void KWinScreenEdgesConfig::save()
     m_form->reload();
 
     // Reload KWin.
-    QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-    QDBusConnection::sessionBus().send(message);
+    QList<KCoreConfigSkeleton*> settings{m_data->settings()};
+    for (auto setting : qAsConst(m_scriptSettings)) {
+        settings << setting;
+    }
+    for (auto setting : qAsConst(m_effectSettings)) {
+        settings << setting;
+    }
+    reloadConfigGroups(kwinrcGroups(settings));
     // and reconfigure the effects
     OrgKdeKwinEffectsInterface interface(
         QStringLiteral("org.kde.KWin"), QStringLiteral("/Effects"), QDBusConnection::sessionBus());
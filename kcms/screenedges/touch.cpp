@@ -21,6 +21,7 @@ SPDX-License-Identifier: GPL-2.0-or-later
 #include "kwintouchscreenedgeeffectsettings.h"
 #include "kwintouchscreenscriptsettings.h"
 #include "kwintouchscreensettings.h"
+#include "reloadconfig.h"
 
 K_PLUGIN_FACTORY_WITH_JSON(KWinScreenEdgesConfigFactory,
                            "kcm_kwintouchscreen.json",
@@ -87,8 +88,14 @@ void KWinScreenEdgesConfig::save()
     m_form->reload();
 
     // Reload KWin.
-    QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-    QDBusConnection::sessionBus().send(message);
+    QList<KCoreConfigSkeleton*> settings{m_data->settings()};
+    for (auto setting : qAsConst(m_scriptSettings)) {
+        settings << setting;
+    }
+    for (auto setting : qAsConst(m_effectSettings)) {
+        settings << setting;
+    }
+    reloadConfigGroups(kwinrcGroups(settings));
     // and reconfigure the effects
     OrgKdeKwinEffectsInterface interface(
         QStringLiteral("org.kde.KWin"), QStringLiteral("/Effects"), QDBusConnection::sessionBus());
@@ -13,6 +13,7 @@ SPDX-License-Identifier: GPL-2.0-or-later
 #include "kwintabboxdata.h"
 #include "kwintabboxsettings.h"
 #include "layoutpreview.h"
+#include "reloadconfig.h"
 #include "shortcutsettings.h"
 #include <kwin_effects_interface.h>
 
@@ -246,8 +247,9 @@ void KWinTabBoxConfig::save()
     updateUnmanagedState();
 
     // Reload KWin.
-    QDBusMessage message = QDBusMessage::createSignal("/KWin", "org.kde.KWin", "reloadConfig");
-    QDBusConnection::sessionBus().send(message);
+    reloadConfigGroups(kwinrcGroups({m_data->tabBoxConfig(),
+                                     m_data->tabBoxAlternativeConfig(),
+                                     m_data->pluginsConfig()}));
 }
 
 void KWinTabBoxConfig::defaults()
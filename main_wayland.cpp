@@ -6,6 +6,39 @@ SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "main.h"
 
+#include "config-theseus-ship.h"
+
+#include "base/config_enabled.h"
+#include "base/config_reload.h"
+#include "base/idle_housekeeping.h"
+#include "base/isolation.h"
+#include "base/memory_lock.h"
+#include "base/process_launcher.h"
+#include "base/protocol_logger.h"
+#include "base/readiness.h"
+#include "base/scheduling.h"
+#include "base/signal_notifier.h"
+#include "base/socket_fd.h"
+#include "base/startup_idle.h"
+#include "benchmark/benchmark.h"
+#include "benchmark/input_recorder.h"
+#include "benchmark/input_replay.h"
+#include "debug/client_accounting.h"
+#if KWIN_BUILD_DBUS_ACCOUNTING
+#include "debug/dbus_accounting.h"
+#endif
+#include "debug/event_dispatch.h"
+#include "debug/fd_accounting.h"
+#include "debug/input_latency.h"
+#include "debug/input_watch.h"
+#include "debug/memory_report.h"
+#include "debug/page_faults.h"
+#include "debug/stall_watchdog.h"
+#include "debug/startup_profile.h"
+#include "debug/trace_recorder.h"
+#include "input/motion_coalescing.h"
+#include "xwl/on_demand.h"
+
 #include <como/base/wayland/app_singleton.h>
 #include <como/base/wayland/xwl_platform.h>
 #include <como/desktop/kde/platform.h>
@@ -19,8 +52,10 @@ SPDX-License-Identifier: GPL-2.0-or-later
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDebug>
-#include <QProcess>
+#include <QTimer>
+#include <iostream>
 #include <sys/resource.h>
+#include <wayland-server-core.h>
 
 namespace theseus_ship
 {
@@ -29,6 +64,10 @@ template<typename Base>
 struct input_mod {
     using platform_t = como::input::wayland::platform<Base, input_mod>;
     std::unique_ptr<como::input::dbus::device_manager<platform_t>> dbus;
+    std::unique_ptr<debug::input_latency_tracer> latency;
+    std::unique_ptr<benchmark::input_recorder<platform_t>> recorder;
+    std::unique_ptr<benchmark::input_replay<platform_t>> replay;
+    std::unique_ptr<input::motion_coalescer<platform_t>> coalescer;
 };
 
 struct space_mod {
@@ -41,6 +80,8 @@ struct base_mod {
     using input_t = como::input::wayland::platform<platform_t, input_mod<platform_t>>;
     using space_t = como::win::wayland::xwl_space<platform_t, space_mod>;
 
+    // First, so it outlives the modules that add handlers to it.
+    std::unique_ptr<base::protocol_logger> protocol_logger;
     std::unique_ptr<render_t> render;
     std::unique_ptr<input_t> input;
     std::unique_ptr<space_t> space;
@@ -71,6 +112,7 @@ static void bumpNofileLimit()
     // It's easy to exceed the file descriptor limit because many things are backed using fds
     // nowadays, e.g. dmabufs, shm buffers, etc. Bump the RLIMIT_NOFILE limit to handle that.
     // Some apps may still use select(), so we reset the limit to its original value in fork().
+    // Applications we launch ourselves get the limit reset by the process launcher.
 
     if (getrlimit(RLIMIT_NOFILE, &originalNofileLimit) == -1) {
         std::cerr << "Failed to bump RLIMIT_NOFILE limit, getrlimit() failed: " << strerror(errno)
@@ -91,29 +133,48 @@ static void bumpNofileLimit()
 }
 
 struct exit_process_t {
-    exit_process_t(QApplication& app)
-        : app{&app}
-    {
-    }
     ~exit_process_t()
     {
-        if (process && process->state() != QProcess::NotRunning) {
-            QObject::disconnect(process, nullptr, app, nullptr);
-            process->terminate();
-            process->waitForFinished(5000);
+        if (process) {
+            process->exited = {};
+            process->terminate(std::chrono::seconds(5));
         }
     }
 
-    QApplication* app;
-    QProcess* process{nullptr};
+    std::unique_ptr<theseus_ship::base::child_process> process;
 };
 
+void record_launch(theseus_ship::debug::startup_profile& profile,
+                   theseus_ship::base::launch_result const& result,
+                   std::chrono::microseconds begin)
+{
+    if (result.pid < 0) {
+        qWarning("Failed to launch %s: %s", qPrintable(result.program), strerror(result.error));
+        return;
+    }
+
+    qDebug("Launched %s (pid %d) in %lld us",
+           qPrintable(result.program),
+           result.pid,
+           static_cast<long long>(result.latency.count()));
+
+    profile.events.push_back({
+        .name = QStringLiteral("launch ") + result.program,
+        .category = QStringLiteral("launch"),
+        .start = begin,
+        .duration = result.latency,
+        .tid = gettid(),
+    });
+}
+
 }
 
 int main(int argc, char* argv[])
 {
     using namespace theseus_ship;
 
+    debug::startup_profile startup_profile;
+
     // Redirect stderr output. This is useful as a workaround for missing logs in systemd journal
     // when launching a full Plasma session.
     if (auto log_path = getenv("KWIN_LOG_PATH")) {
@@ -145,11 +206,21 @@ int main(int argc, char* argv[])
             QStringLiteral("xwayland"),
             i18n("Start a rootless Xwayland server."),
         };
+        QCommandLineOption xwl_on_demand = {
+            QStringLiteral("xwayland-on-demand"),
+            i18n("Start a rootless Xwayland server once the first X11 client connects."),
+        };
         QCommandLineOption socket = {
             QStringList{QStringLiteral("s"), QStringLiteral("socket")},
             i18n("Name of the Wayland socket to listen on. If not set \"wayland-0\" is used."),
             QStringLiteral("socket"),
         };
+        QCommandLineOption socket_fd = {
+            QStringLiteral("socket-fd"),
+            i18n("Accept clients also on this already bound and listening socket. Without it a "
+                 "socket passed through socket activation is used."),
+            QStringLiteral("fd"),
+        };
         QCommandLineOption lockscreen = {
             QStringLiteral("lockscreen"),
             i18n("Starts the session in locked mode."),
@@ -167,18 +238,80 @@ int main(int argc, char* argv[])
             i18n("Exit after the session application, which is started by KWin, closed."),
             QStringLiteral("/path/to/session"),
         };
+        QCommandLineOption startup_profile = {
+            QStringLiteral("startup-profile"),
+            i18n("Write the duration of each startup phase as a Chrome trace to the given file."),
+            QStringLiteral("file"),
+        };
+        QCommandLineOption ready_fd = {
+            QStringLiteral("ready-fd"),
+            i18n("Write the name of the Wayland socket to the given file descriptor and close it "
+                 "once clients can connect."),
+            QStringLiteral("fd"),
+        };
+        QCommandLineOption benchmark = {
+            QStringLiteral("benchmark"),
+            i18n("Run synthetic clients on a virtual output, print performance statistics and "
+                 "exit."),
+        };
+        QCommandLineOption benchmark_clients = {
+            QStringLiteral("benchmark-clients"),
+            i18n("Number of synthetic clients in benchmark mode."),
+            QStringLiteral("count"),
+            QStringLiteral("4"),
+        };
+        QCommandLineOption benchmark_rate = {
+            QStringLiteral("benchmark-rate"),
+            i18n("Commits per second of each synthetic client in benchmark mode."),
+            QStringLiteral("hz"),
+            QStringLiteral("60"),
+        };
+        QCommandLineOption benchmark_duration = {
+            QStringLiteral("benchmark-duration"),
+            i18n("Duration of the benchmark in seconds."),
+            QStringLiteral("seconds"),
+            QStringLiteral("10"),
+        };
+        QCommandLineOption record_input = {
+            QStringLiteral("record-input"),
+            i18n("Record the events of all input devices to a file."),
+            QStringLiteral("file"),
+        };
+        QCommandLineOption replay_input = {
+            QStringLiteral("replay-input"),
+            i18n("Replay the input events of a recording through virtual input devices. Only "
+                 "with the headless backend, for example with --benchmark."),
+            QStringLiteral("file"),
+        };
     } options;
 
+    theseus_ship::base::scheduling_options scheduling_options;
+    theseus_ship::base::isolation_options isolation_options;
+    theseus_ship::base::memory_lock_options memory_lock_options;
+
     QCommandLineParser parser;
     parser.setApplicationDescription(i18n("KWinFT Wayland Window Manager"));
     KAboutData::applicationData().setupCommandLine(&parser);
 
     parser.addOption(options.xwl);
+    parser.addOption(options.xwl_on_demand);
     parser.addOption(options.socket);
+    parser.addOption(options.socket_fd);
     parser.addOption(options.no_lockscreen);
     parser.addOption(options.no_global_shortcuts);
     parser.addOption(options.lockscreen);
     parser.addOption(options.exit_with_session);
+    parser.addOption(options.startup_profile);
+    parser.addOption(options.ready_fd);
+    parser.addOption(options.benchmark);
+    parser.addOption(options.benchmark_clients);
+    parser.addOption(options.benchmark_rate);
+    parser.addOption(options.benchmark_duration);
+    parser.addOption(options.record_input);
+    parser.addOption(options.replay_input);
+    scheduling_options.add_to(parser);
+    isolation_options.add_to(parser);
+    memory_lock_options.add_to(parser);
     parser.addPositionalArgument(QStringLiteral("applications"),
                                  i18n("Applications to start once server is started"),
                                  QStringLiteral("[/path/to/application...]"));
@@ -189,6 +322,8 @@ int main(int argc, char* argv[])
         qWarning() << "Can't enable Ftrace via environment variable.";
     }
 
+    auto trace_recorder = debug::create_trace_recorder();
+
     KSignalHandler::self()->watchSignal(SIGTERM);
     KSignalHandler::self()->watchSignal(SIGINT);
     KSignalHandler::self()->watchSignal(SIGHUP);
@@ -201,11 +336,32 @@ int main(int argc, char* argv[])
 
     parser.process(*app.qapp);
     KAboutData::applicationData().processCommandLine(&parser);
+    startup_profile.path = parser.value(options.startup_profile);
+
+    auto const benchmark = parser.isSet(options.benchmark);
+    if (benchmark) {
+        theseus_ship::benchmark::setup_headless_environment();
+    }
+
+    std::optional<std::vector<theseus_ship::benchmark::input_record>> input_replay_records;
+    if (parser.isSet(options.replay_input)) {
+        // Real devices would interleave their events with the replayed ones.
+        if (!theseus_ship::benchmark::is_headless_environment()) {
+            std::cerr << "Input can only be replayed with the headless backend." << std::endl;
+            return 1;
+        }
+        input_replay_records
+            = theseus_ship::benchmark::read_recording(parser.value(options.replay_input));
+        if (!input_replay_records) {
+            std::cerr << "Failed to read input recording." << std::endl;
+            return 1;
+        }
+    }
 
     auto flags = como::base::wayland::start_options::none;
     if (parser.isSet(options.lockscreen)) {
         flags = como::base::wayland::start_options::lock_screen;
-    } else if (!parser.isSet(options.no_lockscreen)) {
+    } else if (!parser.isSet(options.no_lockscreen) && !benchmark) {
         flags = como::base::wayland::start_options::lock_screen_integration;
     }
     if (parser.isSet(options.no_global_shortcuts)) {
@@ -214,32 +370,163 @@ int main(int argc, char* argv[])
 
     qDebug("Starting Theseus' Ship (Wayland) %s", "0.0.0");
 
-    exit_process_t exit_process(*app.qapp);
+    exit_process_t exit_process;
 
     using base_t = como::base::wayland::xwl_platform<base_mod>;
+
+    // Parsing the whole cascade of kwinrc is measured on its own.
+    auto const config_begin = debug::trace_clock_now();
+    auto config = como::base::config(KConfig::OpenFlag::FullConfig, "kwinrc");
+    startup_profile.add("config", config_begin);
+
+    auto const base_begin = debug::trace_clock_now();
     base_t base({
-        .config = como::base::config(KConfig::OpenFlag::FullConfig, "kwinrc"),
+        .config = std::move(config),
         .socket_name = parser.value(options.socket).toStdString(),
         .flags = flags,
+        // With Xwayland on demand the mode is switched once Xwayland is created. Until then
+        // nothing may expect it to exist.
         .mode = parser.isSet(options.xwl) ? como::base::operation_mode::xwayland
                                           : como::base::operation_mode::wayland,
     });
+    startup_profile.add("base", base_begin);
+    base.mod.protocol_logger
+        = std::make_unique<theseus_ship::base::protocol_logger>(base.server->display->native());
+
+    // Render and input threads are only created by the platforms. They get their settings once
+    // they are found.
+    theseus_ship::base::thread_scheduling thread_scheduling;
+    thread_scheduling.set(
+        scheduling_options.read(parser, base.config.main->group(QStringLiteral("Scheduling"))));
+    qInfo() << "Main thread scheduling:" << theseus_ship::base::describe_scheduling();
+
+    auto stall_watchdog
+        = debug::create_stall_watchdog(base.config.main->group(QStringLiteral("StallWatchdog")));
+
+    theseus_ship::base::signal_notifier dump_signal(SIGUSR2);
+    // The watchdog may be enabled or disabled on config reload.
+    dump_signal.add([&] {
+        if (stall_watchdog) {
+            qWarning().noquote() << stall_watchdog->dump();
+        }
+    });
+    if (trace_recorder) {
+        dump_signal.add([&] { qInfo() << "Trace written to" << trace_recorder->dump({}); });
+    }
 
-    base.mod.render = std::make_unique<base_t::render_t>(base);
+    debug::memory_report memory_report;
+    auto page_fault_monitor = theseus_ship::base::create_if_enabled<debug::page_fault_monitor>(
+        base.config.main->group(QStringLiteral("PageFaults")));
+    theseus_ship::base::signal_notifier memory_signal(SIGUSR1);
+    // The page fault monitor may be enabled or disabled on config reload.
+    memory_signal.add([&] {
+        qInfo().noquote() << memory_report.report();
+        if (page_fault_monitor) {
+            qInfo().noquote() << page_fault_monitor->summary();
+        }
+    });
 
-    base.mod.input
-        = std::make_unique<base_t::input_t>(base, como::input::config(KConfig::NoGlobals));
-    base.mod.input->mod.dbus
-        = std::make_unique<como::input::dbus::device_manager<base_t::input_t>>(*base.mod.input);
+    // Locking right away would also lock what is only needed during startup.
+    std::unique_ptr<theseus_ship::base::memory_lock> memory_lock;
+    auto const memory_lock_settings = memory_lock_options.read(
+        parser, base.config.main->group(QStringLiteral("MemoryLock")));
+    if (memory_lock_settings.enabled) {
+        theseus_ship::base::on_startup_idle(app.qapp.get(), [&, memory_lock_settings] {
+            memory_lock = std::make_unique<theseus_ship::base::memory_lock>(memory_lock_settings);
+            auto const result = memory_lock->lock();
+            qInfo() << "Locked" << result.data / 1024 << "KiB of data and" << result.code / 1024
+                    << "KiB of code," << result.skipped / 1024 << "KiB did not fit";
+        });
+    }
 
-    base.mod.space = std::make_unique<base_t::space_t>(*base.mod.render, *base.mod.input);
-    base.mod.space->mod.desktop
-        = std::make_unique<como::desktop::kde::platform<base_t::space_t>>(*base.mod.space);
-    como::win::init_shortcuts(*base.mod.space);
-    como::render::init_shortcuts(*base.mod.render);
-    base.mod.script = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
+    // Heap allocated while constructing the members of base_mod is accounted to them.
 
-    como::base::wayland::platform_start(base);
+    startup_profile.measure("render", [&] {
+        debug::memory_scope memory_scope(debug::memory_tag::render);
+        base.mod.render = std::make_unique<base_t::render_t>(base);
+    });
+
+    startup_profile.measure("input", [&] {
+        debug::memory_scope memory_scope(debug::memory_tag::input);
+        base.mod.input
+            = std::make_unique<base_t::input_t>(base, como::input::config(KConfig::NoGlobals));
+        base.mod.input->mod.dbus
+            = std::make_unique<como::input::dbus::device_manager<base_t::input_t>>(
+                *base.mod.input);
+        base.mod.input->mod.latency
+            = theseus_ship::base::create_if_enabled<debug::input_latency_tracer>(
+                base.config.main->group(QStringLiteral("InputLatency")), *base.mod.protocol_logger);
+
+        if (parser.isSet(options.record_input)) {
+            base.mod.input->mod.recorder
+                = std::make_unique<theseus_ship::benchmark::input_recorder<base_t::input_t>>(
+                    *base.mod.input, parser.value(options.record_input));
+        }
+    });
+
+    startup_profile.measure("space", [&] {
+        debug::memory_scope memory_scope(debug::memory_tag::space);
+        base.mod.space = std::make_unique<base_t::space_t>(*base.mod.render, *base.mod.input);
+    });
+
+    // The pointer redirect of the space connects to the devices, which the coalescer replaces.
+    auto const coalescing = base.config.main->group(QStringLiteral("MotionCoalescing"));
+    if (base.mod.input->mod.recorder && coalescing.readEntry("Enabled", false)) {
+        // The recording must contain the events of the devices as they are.
+        qInfo() << "Pointer motion is not coalesced while input is recorded.";
+    } else {
+        base.mod.input->mod.coalescer = theseus_ship::base::create_if_enabled<
+            theseus_ship::input::motion_coalescer<base_t::input_t>>(
+            coalescing,
+            *base.mod.input,
+            base.mod.space->input->pointer->qobject.get(),
+            *base.mod.protocol_logger,
+            [&base] {
+                // Refresh rates are in mHz.
+                int refresh{60000};
+                for (auto output : base.outputs) {
+                    refresh = std::max(refresh, output->refresh_rate());
+                }
+                return std::chrono::nanoseconds(std::chrono::seconds(1)) * 1000 / refresh;
+            });
+    }
+
+    startup_profile.measure("desktop", [&] {
+        debug::memory_scope memory_scope(debug::memory_tag::space);
+        base.mod.space->mod.desktop
+            = std::make_unique<como::desktop::kde::platform<base_t::space_t>>(*base.mod.space);
+    });
+    startup_profile.measure("shortcuts", [&] {
+        como::win::init_shortcuts(*base.mod.space);
+        como::render::init_shortcuts(*base.mod.render);
+    });
+
+    auto start_scripting = [&] {
+        startup_profile.measure("scripting", [&] {
+            debug::memory_scope memory_scope(debug::memory_tag::script);
+            base.mod.script
+                = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
+        });
+    };
+
+    // Loading and evaluating all enabled scripts can take a considerable amount of time. In the
+    // deferred mode the scripting platform is created in one go once the event loop went quiet
+    // after startup.
+    auto const defer_scripting = base.config.main->group(QStringLiteral("Scripting"))
+                                     .readEntry("DeferredStart", false);
+    if (defer_scripting) {
+        theseus_ship::base::on_startup_idle(app.qapp.get(), [&] {
+            start_scripting();
+            startup_profile.write();
+        });
+    } else {
+        start_scripting();
+    }
+
+    startup_profile.measure("platform start", [&] {
+        debug::memory_scope memory_scope(debug::memory_tag::render);
+        como::base::wayland::platform_start(base);
+    });
 
     base.process_environment = QProcessEnvironment::systemEnvironment();
 
@@ -247,56 +534,228 @@ int main(int argc, char* argv[])
         base.process_environment.insert(QStringLiteral("WAYLAND_DISPLAY"), name.c_str());
     }
 
-    base.server->init_screen_locker();
-
-    if (base.operation_mode == como::base::operation_mode::xwayland) {
-        try {
-            base.mod.xwayland
-                = std::make_unique<como::xwl::xwayland<base_t::space_t>>(*base.mod.space);
-        } catch (std::system_error const& exc) {
-            std::cerr << "FATAL ERROR creating Xwayland: " << exc.what() << std::endl;
-            exit(exc.code().value());
-        } catch (std::exception const& exc) {
-            std::cerr << "FATAL ERROR creating Xwayland: " << exc.what() << std::endl;
-            exit(1);
+    // A session manager may have created this socket and started clients already. They are
+    // accepted with the first event loop iteration.
+    {
+        auto socket_fd = theseus_ship::base::activated_socket(base.process_environment);
+        if (parser.isSet(options.socket_fd)) {
+            bool ok{false};
+            socket_fd = parser.value(options.socket_fd).toInt(&ok);
+            if (!ok) {
+                socket_fd = -1;
+                qWarning() << "Invalid socket fd:" << parser.value(options.socket_fd);
+            }
+        }
+        if (socket_fd >= 0) {
+            theseus_ship::base::add_listening_socket(base.server->display->native(), socket_fd);
         }
     }
 
+    // The socket accepts connections from here on. Whoever waits on us can start Wayland clients
+    // while we still set up the rest of the session.
+    auto const socket_name = QByteArray::fromStdString(base.server->display->socket_name());
+    if (parser.isSet(options.ready_fd)) {
+        bool ok{false};
+        auto const fd = parser.value(options.ready_fd).toInt(&ok);
+        if (ok && fd >= 0) {
+            theseus_ship::base::write_ready_fd(fd, socket_name);
+        } else {
+            qWarning() << "Invalid ready fd:" << parser.value(options.ready_fd);
+        }
+    }
+
+    startup_profile.measure("screen locker", [&] { base.server->init_screen_locker(); });
+
+    auto housekeeping = theseus_ship::base::create_idle_housekeeping(
+        *base.mod.protocol_logger, base.config.main->group(QStringLiteral("Housekeeping")));
+    auto fd_accounting = debug::create_fd_accounting(
+        base.server->display->native(), base.config.main->group(QStringLiteral("FdAccounting")));
+    auto client_accounting = theseus_ship::base::create_if_enabled<debug::client_accounting>(
+        base.config.main->group(QStringLiteral("ClientAccounting")), *base.mod.protocol_logger);
+
+    auto const wayland_fd
+        = wl_event_loop_get_fd(wl_display_get_event_loop(base.server->display->native()));
+    auto event_dispatch = theseus_ship::base::create_if_enabled<debug::event_dispatch_monitor>(
+        base.config.main->group(QStringLiteral("EventDispatch")), wayland_fd);
+    auto create_input_watch = [&](auto const& group) {
+        auto watch = theseus_ship::base::create_if_enabled<debug::input_watch>(group);
+        if (watch) {
+            debug::watch_input_events(*watch, *base.mod.input);
+        }
+        return watch;
+    };
+    auto input_watch = create_input_watch(base.config.main->group(QStringLiteral("InputWatch")));
+
+    // Only construction is accounted by the scopes above. Afterwards allocations are accounted by
+    // the source of the events the main thread dispatches.
+    auto dispatch_memory_tags = debug::create_dispatch_memory_tags(wayland_fd);
+
+#if KWIN_BUILD_DBUS_ACCOUNTING
+    // Created last, so its event filter runs first and the other filters see each D-Bus call once
+    // while it is handled.
+    std::unique_ptr<debug::dbus_accounting> dbus_accounting;
+    auto create_dbus_accounting = [&] {
+        dbus_accounting.reset();
+        dbus_accounting = debug::create_dbus_accounting(
+            base.config.main->group(QStringLiteral("DBusAccounting")));
+    };
+    create_dbus_accounting();
+#endif
+
+    theseus_ship::base::config_reload config_reload(base.config.main);
+    auto reload_group = [&](auto const& name, auto& object, auto create) {
+        config_reload.add(name, [&, name, create] {
+            // The old object must unregister from D-Bus first.
+            object.reset();
+            object = create(base.config.main->group(name));
+        });
+    };
+    reload_group(QStringLiteral("StallWatchdog"), stall_watchdog, [](auto const& group) {
+        return debug::create_stall_watchdog(group);
+    });
+    reload_group(QStringLiteral("PageFaults"), page_fault_monitor, [](auto const& group) {
+        return theseus_ship::base::create_if_enabled<debug::page_fault_monitor>(group);
+    });
+    reload_group(QStringLiteral("Housekeeping"), housekeeping, [&](auto const& group) {
+        return theseus_ship::base::create_idle_housekeeping(*base.mod.protocol_logger, group);
+    });
+    reload_group(QStringLiteral("FdAccounting"), fd_accounting, [&](auto const& group) {
+        return debug::create_fd_accounting(base.server->display->native(), group);
+    });
+    reload_group(QStringLiteral("ClientAccounting"), client_accounting, [&](auto const& group) {
+        return theseus_ship::base::create_if_enabled<debug::client_accounting>(
+            group, *base.mod.protocol_logger);
+    });
+    reload_group(
+        QStringLiteral("InputLatency"), base.mod.input->mod.latency, [&](auto const& group) {
+            return theseus_ship::base::create_if_enabled<debug::input_latency_tracer>(
+                group, *base.mod.protocol_logger);
+        });
+    config_reload.add(QStringLiteral("EventDispatch"), [&] {
+        event_dispatch.reset();
+        event_dispatch = theseus_ship::base::create_if_enabled<debug::event_dispatch_monitor>(
+            base.config.main->group(QStringLiteral("EventDispatch")), wayland_fd);
+#if KWIN_BUILD_DBUS_ACCOUNTING
+        if (dbus_accounting) {
+            create_dbus_accounting();
+        }
+#endif
+    });
+    reload_group(QStringLiteral("InputWatch"), input_watch, create_input_watch);
+#if KWIN_BUILD_DBUS_ACCOUNTING
+    config_reload.add(QStringLiteral("DBusAccounting"), create_dbus_accounting);
+#endif
+    config_reload.add(QStringLiteral("Scheduling"), [&] {
+        thread_scheduling.set(scheduling_options.read(
+            parser, base.config.main->group(QStringLiteral("Scheduling"))));
+    });
+
+    // Effects are reconfigured by the KCMs through the Effects interface.
+    config_reload.add(QStringLiteral("Effect-"), [] {}, true);
+
+    // Without listening sockets Xwayland picks a display itself.
+    auto start_xwayland = [&](QString const& display, std::vector<int> const& listen_fds) {
+        startup_profile.measure("xwayland", [&] {
+            debug::memory_scope memory_scope(debug::memory_tag::xwayland);
+            try {
+                base.operation_mode = como::base::operation_mode::xwayland;
+                base.mod.xwayland = listen_fds.empty()
+                    ? std::make_unique<como::xwl::xwayland<base_t::space_t>>(*base.mod.space)
+                    : std::make_unique<como::xwl::xwayland<base_t::space_t>>(
+                        *base.mod.space, display.toStdString(), listen_fds);
+            } catch (std::system_error const& exc) {
+                std::cerr << "FATAL ERROR creating Xwayland: " << exc.what() << std::endl;
+                exit(exc.code().value());
+            } catch (std::exception const& exc) {
+                std::cerr << "FATAL ERROR creating Xwayland: " << exc.what() << std::endl;
+                exit(1);
+            }
+        });
+    };
+
+    std::unique_ptr<xwl::on_demand> xwayland_on_demand;
+
+    if (parser.isSet(options.xwl) || parser.isSet(options.xwl_on_demand)) {
+        if (parser.isSet(options.xwl_on_demand) && !parser.isSet(options.xwl)) {
+            // The display is reserved and exported right away. Xwayland itself is only started
+            // once the first X11 client connects to it.
+            xwayland_on_demand = std::make_unique<xwl::on_demand>([&](auto const& listen_fds) {
+                start_xwayland(xwayland_on_demand->display_name(), listen_fds);
+            });
+
+            if (xwayland_on_demand->reserve()) {
+                base.process_environment.insert(QStringLiteral("DISPLAY"),
+                                                xwayland_on_demand->display_name());
+            } else {
+                qWarning() << "Failed to reserve an X11 display. Starting Xwayland right away.";
+                xwayland_on_demand.reset();
+                start_xwayland({}, {});
+            }
+        } else {
+            start_xwayland({}, {});
+        }
+    }
+
+    // Services started after us may be X11 clients or need the lock screen, so the service
+    // manager is only notified once both are set up.
+    {
+        auto status = "Listening on " + socket_name;
+        if (auto const display = base.process_environment.value(QStringLiteral("DISPLAY"));
+            !display.isEmpty()) {
+            status += " and " + display.toUtf8();
+        }
+        theseus_ship::base::sd_notify_ready(base.process_environment, status);
+        startup_profile.mark("ready");
+    }
+
     auto process_environment = base.process_environment;
 
     // Enforce Wayland platform for started Qt apps. They otherwise for some reason prefer X11.
     process_environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("wayland"));
 
+    theseus_ship::base::process_launcher launcher(
+        process_environment,
+        originalNofileLimit,
+        // The scheduling of the compositor is not meant for the applications it launches.
+        thread_scheduling.original_affinity(),
+        thread_scheduling.original_nice(),
+        isolation_options.read(parser, base.config.main->group(QStringLiteral("Launcher"))));
+
+    // Need to create a launch environment job for Plasma components to catch up in a systemd boot.
+    // This implies we're running in a full Plasma session i.e. when we use the wrapper (that's
+    // there the service name comes from), but we can also do it in a plain setup without session.
+    // Registering the service names indicates that we're live and all env vars are exported.
+    // The job only sends asynchronous D-Bus calls, so the session is spawned while it runs.
+    auto env_sync_job = new KUpdateLaunchEnvironmentJob(process_environment);
+    QObject::connect(env_sync_job, &KUpdateLaunchEnvironmentJob::finished, app.qapp.get(), []() {
+        QDBusConnection::sessionBus().registerService(QStringLiteral("org.kde.KWinWrapper"));
+    });
+
     // start session
     if (parser.isSet(options.exit_with_session) /*&& !m_sessionArgument.isEmpty()*/) {
-        auto arguments = KShell::splitArgs(parser.value(options.exit_with_session));
-        if (!arguments.isEmpty()) {
-            QString program = arguments.takeFirst();
-            auto p = new QProcess(app.qapp.get());
-            p->setProcessChannelMode(QProcess::ForwardedErrorChannel);
-            p->setProcessEnvironment(process_environment);
-            QObject::connect(p,
-                             qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
-                             app.qapp.get(),
-                             [&exit_process, p](auto code, auto status) {
-                                 exit_process.process = {};
-                                 p->deleteLater();
-                                 if (status == QProcess::CrashExit) {
-                                     qWarning() << "Session process has crashed";
-                                     QCoreApplication::exit(-1);
-                                     return;
-                                 }
-
-                                 if (code) {
-                                     qWarning() << "Session process exited with code" << code;
-                                 }
-
-                                 QCoreApplication::exit(code);
-                             });
-            p->setProgram(program);
-            p->setArguments(arguments);
-            p->start();
-            exit_process.process = p;
+        auto command = KShell::splitArgs(parser.value(options.exit_with_session));
+        if (!command.isEmpty()) {
+            auto const launch_begin = debug::trace_clock_now();
+            auto const result = launcher.spawn(command);
+            record_launch(startup_profile, result, launch_begin);
+
+            if (result.pid > 0) {
+                exit_process.process
+                    = std::make_unique<theseus_ship::base::child_process>(result.pid);
+                exit_process.process->exited = [](auto code, auto crashed) {
+                    if (crashed) {
+                        qWarning() << "Session process has crashed";
+                        QCoreApplication::exit(-1);
+                        return;
+                    }
+
+                    if (code) {
+                        qWarning() << "Session process exited with code" << code;
+                    }
+
+                    QCoreApplication::exit(code);
+                };
+            }
         } else {
             qWarning("Failed to launch the session process: %s is an invalid command",
                      qPrintable(parser.value(options.exit_with_session)));
@@ -304,34 +763,61 @@ int main(int argc, char* argv[])
     }
 
     // start the applications passed to us as command line arguments
-    if (auto apps = parser.positionalArguments(); !apps.isEmpty()) {
-        for (auto const& app_name : qAsConst(apps)) {
-            auto arguments = KShell::splitArgs(app_name);
-            if (arguments.isEmpty()) {
+    std::vector<std::unique_ptr<theseus_ship::base::child_process>> apps;
+
+    if (auto const app_names = parser.positionalArguments(); !app_names.isEmpty()) {
+        std::vector<QStringList> commands;
+        for (auto const& app_name : app_names) {
+            auto command = KShell::splitArgs(app_name);
+            if (command.isEmpty()) {
                 qWarning("Failed to launch application: %s is an invalid command",
                          qPrintable(app_name));
                 continue;
             }
-            QString program = arguments.takeFirst();
-            // note: this will kill the started process when we exit
-            // this is going to happen anyway as we are the wayland and X server the app connects to
-            auto p = new QProcess(app.qapp.get());
-            p->setProcessChannelMode(QProcess::ForwardedErrorChannel);
-            p->setProcessEnvironment(process_environment);
-            p->setProgram(program);
-            p->setArguments(arguments);
-            p->startDetached();
-            p->deleteLater();
+            commands.push_back(command);
+        }
+
+        auto const launch_begin = debug::trace_clock_now();
+        for (auto const& result : launcher.spawn_all(commands)) {
+            record_launch(startup_profile, result, launch_begin);
+
+            // The applications are not terminated when we exit. They will go down anyway as they
+            // lose their connection to the Wayland and X server. We only reap them.
+            if (result.pid > 0) {
+                apps.push_back(std::make_unique<theseus_ship::base::child_process>(result.pid));
+            }
         }
     }
 
-    // Need to create a launch environment job for Plasma components to catch up in a systemd boot.
-    // This implies we're running in a full Plasma session i.e. when we use the wrapper (that's
-    // there the service name comes from), but we can also do it in a plain setup without session.
-    // Registering the service names indicates that we're live and all env vars are exported.
-    auto env_sync_job = new KUpdateLaunchEnvironmentJob(process_environment);
-    QObject::connect(env_sync_job, &KUpdateLaunchEnvironmentJob::finished, app.qapp.get(), []() {
-        QDBusConnection::sessionBus().registerService(QStringLiteral("org.kde.KWinWrapper"));
+    std::unique_ptr<theseus_ship::benchmark::benchmark> benchmark_run;
+    if (benchmark) {
+        benchmark_run = std::make_unique<theseus_ship::benchmark::benchmark>(
+            theseus_ship::benchmark::benchmark_settings{
+                .clients = std::max(1, parser.value(options.benchmark_clients).toInt()),
+                .duration = std::chrono::seconds(
+                    std::max(1, parser.value(options.benchmark_duration).toInt())),
+                .client = {.rate = std::max(1., parser.value(options.benchmark_rate).toDouble())},
+            });
+        benchmark_run->finished = [](auto const& report) {
+            std::cout << qPrintable(report.to_string()) << std::endl;
+            QCoreApplication::exit(report.failed_clients ? 1 : 0);
+        };
+        benchmark_run->start(base.server->display->socket_name());
+    }
+
+    if (input_replay_records) {
+        // Started with the clients, so a benchmark sees the same input at the same time each run.
+        base.mod.input->mod.replay
+            = std::make_unique<theseus_ship::benchmark::input_replay<base_t::input_t>>(
+                *base.mod.input, std::move(*input_replay_records));
+        base.mod.input->mod.replay->start();
+    }
+
+    // The first event loop iteration finishes the startup. Everything until then is on the
+    // critical path to the first frame.
+    QTimer::singleShot(0, app.qapp.get(), [&startup_profile] {
+        startup_profile.mark("event loop");
+        startup_profile.write();
     });
 
     return app.qapp->exec();
@@ -8,6 +8,20 @@
 */
 #include "main.h"
 
+#include "config-theseus-ship.h"
+
+#include "base/config_enabled.h"
+#include "base/config_reload.h"
+#include "base/signal_notifier.h"
+#include "base/startup_idle.h"
+#if KWIN_BUILD_DBUS_ACCOUNTING
+#include "debug/dbus_accounting.h"
+#endif
+#include "debug/event_dispatch.h"
+#include "debug/stall_watchdog.h"
+#include "debug/startup_profile.h"
+#include "debug/trace_recorder.h"
+
 #include <como/base/seat/backend/logind/session.h>
 #include <como/base/x11/app_singleton.h>
 #include <como/base/x11/platform.h>
@@ -87,16 +101,26 @@ int main(int argc, char* argv[])
 {
     using namespace theseus_ship;
 
+    debug::startup_profile startup_profile;
+
     KLocalizedString::setApplicationDomain("kwin");
 
     signal(SIGPIPE, SIG_IGN);
 
+    // SIGUSR2 is received through a signalfd, so no thread may take it.
+    sigset_t user_signals;
+    sigemptyset(&user_signals);
+    sigaddset(&user_signals, SIGUSR2);
+    pthread_sigmask(SIG_BLOCK, &user_signals, nullptr);
+
     como::base::x11::app_singleton app(argc, argv);
 
     if (!como::Perf::Ftrace::setEnabled(qEnvironmentVariableIsSet("KWIN_PERF_FTRACE"))) {
         qWarning() << "Can't enable Ftrace via environment variable.";
     }
 
+    auto trace_recorder = theseus_ship::debug::create_trace_recorder();
+
     KSignalHandler::self()->watchSignal(SIGTERM);
     KSignalHandler::self()->watchSignal(SIGINT);
     KSignalHandler::self()->watchSignal(SIGHUP);
@@ -112,6 +136,10 @@ int main(int argc, char* argv[])
     QCommandLineOption replaceOption(
         QStringLiteral("replace"),
         i18n("Replace already-running ICCCM2.0-compliant window manager"));
+    QCommandLineOption startup_profile_option(
+        QStringLiteral("startup-profile"),
+        i18n("Write the duration of each startup phase as a Chrome trace to the given file."),
+        QStringLiteral("file"));
 
     QCommandLineParser parser;
     parser.setApplicationDescription(i18n("Theseus' Ship X11 Window Manager"));
@@ -119,6 +147,7 @@ int main(int argc, char* argv[])
 
     parser.addOption(crashesOption);
     parser.addOption(replaceOption);
+    parser.addOption(startup_profile_option);
 
     parser.process(*app.qapp);
 
@@ -126,6 +155,7 @@ int main(int argc, char* argv[])
 
     KAboutData::applicationData().processCommandLine(&parser);
     crash_count = parser.value("crashes").toInt();
+    startup_profile.path = parser.value(startup_profile_option);
 
     using base_t = como::base::x11::platform<base_mod>;
     base_t base(como::base::config(KConfig::OpenFlag::FullConfig, "kwinrc"));
@@ -133,9 +163,67 @@ int main(int argc, char* argv[])
     KCrash::setEmergencySaveFunction(crash_handler);
     como::base::x11::platform_init_crash_count(base, crash_count);
 
-    auto handle_ownership_claimed = [&base] {
-        base.options
-            = como::base::create_options(como::base::operation_mode::x11, base.config.main);
+    auto stall_watchdog = theseus_ship::debug::create_stall_watchdog(
+        base.config.main->group(QStringLiteral("StallWatchdog")));
+
+    theseus_ship::base::signal_notifier dump_signal(SIGUSR2);
+    // The watchdog may be enabled or disabled on config reload.
+    dump_signal.add([&] {
+        if (stall_watchdog) {
+            qWarning().noquote() << stall_watchdog->dump();
+        }
+    });
+    if (trace_recorder) {
+        dump_signal.add([&] { qInfo() << "Trace written to" << trace_recorder->dump({}); });
+    }
+
+    auto event_dispatch
+        = theseus_ship::base::create_if_enabled<theseus_ship::debug::event_dispatch_monitor>(
+            base.config.main->group(QStringLiteral("EventDispatch")), -1);
+
+#if KWIN_BUILD_DBUS_ACCOUNTING
+    // Created last, so its event filter runs first and the other filters see each D-Bus call once
+    // while it is handled.
+    std::unique_ptr<theseus_ship::debug::dbus_accounting> dbus_accounting;
+    auto create_dbus_accounting = [&] {
+        dbus_accounting.reset();
+        dbus_accounting = theseus_ship::debug::create_dbus_accounting(
+            base.config.main->group(QStringLiteral("DBusAccounting")));
+    };
+    create_dbus_accounting();
+#endif
+
+    theseus_ship::base::config_reload config_reload(base.config.main);
+    config_reload.add(QStringLiteral("StallWatchdog"), [&] {
+        stall_watchdog.reset();
+        stall_watchdog = theseus_ship::debug::create_stall_watchdog(
+            base.config.main->group(QStringLiteral("StallWatchdog")));
+    });
+    config_reload.add(QStringLiteral("EventDispatch"), [&] {
+        event_dispatch.reset();
+        event_dispatch
+            = theseus_ship::base::create_if_enabled<theseus_ship::debug::event_dispatch_monitor>(
+                base.config.main->group(QStringLiteral("EventDispatch")), -1);
+#if KWIN_BUILD_DBUS_ACCOUNTING
+        if (dbus_accounting) {
+            create_dbus_accounting();
+        }
+#endif
+    });
+#if KWIN_BUILD_DBUS_ACCOUNTING
+    config_reload.add(QStringLiteral("DBusAccounting"), create_dbus_accounting);
+#endif
+
+    // Effects are reconfigured by the KCMs through the Effects interface.
+    config_reload.add(QStringLiteral("Effect-"), [] {}, true);
+
+    auto handle_ownership_claimed = [&app, &base, &startup_profile] {
+        startup_profile.mark("ownership claimed");
+
+        startup_profile.measure("options", [&] {
+            base.options
+                = como::base::create_options(como::base::operation_mode::x11, base.config.main);
+        });
 
         // Check  whether another windowmanager is running
         const uint32_t maskValues[] = {XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT};
@@ -157,39 +245,78 @@ int main(int argc, char* argv[])
             }
         }
 
-        base.session = std::make_unique<como::base::seat::backend::logind::session>();
-        base.mod.render = std::make_unique<como::render::backend::x11::platform<base_t>>(base);
-        base.mod.input = std::make_unique<como::input::x11::platform<base_t>>(base);
+        startup_profile.measure("session", [&] {
+            base.session = std::make_unique<como::base::seat::backend::logind::session>();
+        });
+        startup_profile.measure("render", [&] {
+            base.mod.render = std::make_unique<como::render::backend::x11::platform<base_t>>(base);
+        });
+        startup_profile.measure("input", [&] {
+            base.mod.input = std::make_unique<como::input::x11::platform<base_t>>(base);
+        });
+
+        startup_profile.measure("outputs", [&] { base.update_outputs(); });
 
-        base.update_outputs();
         auto render
             = static_cast<como::render::backend::x11::platform<base_t>*>(base.mod.render.get());
-        try {
-            render->init();
-        } catch (std::exception const&) {
-            std::cerr << "FATAL ERROR: backend failed to initialize, exiting now" << std::endl;
-            ::exit(1);
-        }
-
-        try {
-            base.mod.space = std::make_unique<base_t::space_t>(*base.mod.render, *base.mod.input);
-        } catch (std::exception& ex) {
-            qCCritical(KWIN_CORE) << "Abort since space creation fails with:" << ex.what();
-            exit(1);
+        startup_profile.measure("render init", [&] {
+            try {
+                render->init();
+            } catch (std::exception const&) {
+                std::cerr << "FATAL ERROR: backend failed to initialize, exiting now" << std::endl;
+                ::exit(1);
+            }
+        });
+
+        startup_profile.measure("space", [&] {
+            try {
+                base.mod.space
+                    = std::make_unique<base_t::space_t>(*base.mod.render, *base.mod.input);
+            } catch (std::exception& ex) {
+                qCCritical(KWIN_CORE) << "Abort since space creation fails with:" << ex.what();
+                exit(1);
+            }
+        });
+
+        startup_profile.measure("desktop", [&] {
+            base.mod.space->mod.desktop
+                = std::make_unique<como::desktop::kde::platform<base_t::space_t>>(*base.mod.space);
+        });
+        startup_profile.measure("shortcuts", [&] {
+            como::win::init_shortcuts(*base.mod.space);
+            como::render::init_shortcuts(*base.mod.render);
+        });
+
+        auto start_scripting = [&base, &startup_profile] {
+            startup_profile.measure("scripting", [&] {
+                base.mod.script
+                    = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
+            });
+        };
+
+        // In the deferred mode scripts are only loaded once the event loop went quiet after startup.
+        auto const defer_scripting = base.config.main->group(QStringLiteral("Scripting"))
+                                         .readEntry("DeferredStart", false);
+        if (!defer_scripting) {
+            start_scripting();
         }
 
-        base.mod.space->mod.desktop
-            = std::make_unique<como::desktop::kde::platform<base_t::space_t>>(*base.mod.space);
-        como::win::init_shortcuts(*base.mod.space);
-        como::render::init_shortcuts(*base.mod.render);
-
-        base.mod.script
-            = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
-        render->start(*base.mod.space);
+        startup_profile.measure("render start", [&] { render->start(*base.mod.space); });
 
         // Trigger possible errors, there's still a chance to abort.
-        como::base::x11::xcb::sync(base.x11_data.connection);
+        startup_profile.measure("sync",
+                                [&] { como::base::x11::xcb::sync(base.x11_data.connection); });
         notify_ksplash();
+
+        startup_profile.write();
+
+        if (defer_scripting) {
+            theseus_ship::base::on_startup_idle(app.qapp.get(),
+                                                [start_scripting, &startup_profile] {
+                                                    start_scripting();
+                                                    startup_profile.write();
+                                                });
+        }
     };
 
     como::base::x11::platform_start(base, parser.isSet(replaceOption), handle_ownership_claimed);
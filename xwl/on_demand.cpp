@@ -0,0 +1,207 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "on_demand.h"
+
+#include <QDebug>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+namespace theseus_ship::xwl
+{
+
+namespace
+{
+
+constexpr int max_display{32};
+
+QByteArray lock_file_path(int display)
+{
+    return QByteArrayLiteral("/tmp/.X") + QByteArray::number(display) + QByteArrayLiteral("-lock");
+}
+
+QByteArray socket_path(int display)
+{
+    return QByteArrayLiteral("/tmp/.X11-unix/X") + QByteArray::number(display);
+}
+
+/// Same semantics as the X server: stale lock files of dead processes are taken over.
+bool try_lock(int display)
+{
+    auto const path = lock_file_path(display);
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        auto fd = open(path.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0444);
+        if (fd >= 0) {
+            char pid[12];
+            snprintf(pid, sizeof(pid), "%10d\n", getpid());
+            auto const written = write(fd, pid, sizeof(pid) - 1);
+            close(fd);
+            if (written != sizeof(pid) - 1) {
+                unlink(path.constData());
+                return false;
+            }
+            return true;
+        }
+        if (errno != EEXIST) {
+            return false;
+        }
+
+        fd = open(path.constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        char pid[12]{};
+        auto const count = read(fd, pid, sizeof(pid) - 1);
+        close(fd);
+        if (count != sizeof(pid) - 1) {
+            return false;
+        }
+
+        auto const owner = static_cast<pid_t>(strtol(pid, nullptr, 10));
+        if (owner <= 0 || kill(owner, 0) == 0 || errno != ESRCH) {
+            return false;
+        }
+        if (unlink(path.constData()) != 0) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+int listen_on(QByteArray const& path, bool abstract)
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    // Abstract sockets are identified by a leading null byte and are not null-terminated.
+    auto const offset = abstract ? 1 : 0;
+    memcpy(address.sun_path + offset, path.constData(), path.size());
+    auto const size = offsetof(sockaddr_un, sun_path) + offset + path.size() + (abstract ? 0 : 1);
+
+    if (!abstract) {
+        unlink(path.constData());
+    }
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), size) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}
+
+on_demand::on_demand(std::function<void(std::vector<int> const&)> start)
+    : start{std::move(start)}
+{
+}
+
+on_demand::~on_demand()
+{
+    release();
+}
+
+bool on_demand::reserve()
+{
+    // The mode passed to mkdir is masked by the umask, but other users must be able to create
+    // their sockets in the directory too.
+    if (mkdir("/tmp/.X11-unix", 01777) == 0) {
+        chmod("/tmp/.X11-unix", 01777);
+    }
+
+    for (int candidate = 0; candidate < max_display; candidate++) {
+        if (!try_lock(candidate)) {
+            continue;
+        }
+
+        auto const path = socket_path(candidate);
+        abstract_fd = listen_on(path, true);
+        path_fd = listen_on(path, false);
+
+        if (abstract_fd < 0 || path_fd < 0) {
+            display = candidate;
+            release();
+            continue;
+        }
+
+        display = candidate;
+        break;
+    }
+
+    if (display < 0) {
+        return false;
+    }
+
+    abstract_notifier = std::make_unique<QSocketNotifier>(abstract_fd, QSocketNotifier::Read);
+    path_notifier = std::make_unique<QSocketNotifier>(path_fd, QSocketNotifier::Read);
+    QObject::connect(abstract_notifier.get(), &QSocketNotifier::activated, [this] {
+        handle_connection();
+    });
+    QObject::connect(
+        path_notifier.get(), &QSocketNotifier::activated, [this] { handle_connection(); });
+
+    return true;
+}
+
+QString on_demand::display_name() const
+{
+    return QStringLiteral(":") + QString::number(display);
+}
+
+void on_demand::handle_connection()
+{
+    // Pending connections stay in the backlog of the sockets, where Xwayland accepts them.
+    unwatch();
+
+    qDebug() << "X11 client connected to" << display_name() << "- starting Xwayland on demand";
+    start({abstract_fd, path_fd});
+}
+
+void on_demand::unwatch()
+{
+    // Called from the notifier's activation, so they must not be deleted right away.
+    for (auto notifier : {&abstract_notifier, &path_notifier}) {
+        if (*notifier) {
+            (*notifier)->setEnabled(false);
+            notifier->release()->deleteLater();
+        }
+    }
+}
+
+void on_demand::release()
+{
+    unwatch();
+
+    if (abstract_fd >= 0) {
+        close(abstract_fd);
+        abstract_fd = -1;
+    }
+    if (path_fd >= 0) {
+        close(path_fd);
+        path_fd = -1;
+    }
+
+    if (display >= 0) {
+        unlink(socket_path(display).constData());
+        unlink(lock_file_path(display).constData());
+        display = -1;
+    }
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+SPDX-FileCopyrightText: 2026 Roman Gilg <subdiff@gmail.com>
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QSocketNotifier>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace theseus_ship::xwl
+{
+
+/**
+ * Reserves an X11 display and listens on its sockets until the first X11 client connects. Only
+ * then Xwayland is started through the provided callback, which hands the listening sockets to
+ * Xwayland with -listenfd.
+ *
+ * Xwayland accepts the connections that arrived until then from the backlog of the sockets, so
+ * it sees the credentials of the clients themselves. The display stays reserved by the
+ * compositor until it exits and is never given up in between, so DISPLAY always points to where
+ * Xwayland listens.
+ */
+class on_demand
+{
+public:
+    explicit on_demand(std::function<void(std::vector<int> const& listen_fds)> start);
+    ~on_demand();
+
+    /// Returns false if no display could be reserved.
+    bool reserve();
+
+    /// The reserved display in the form ":<number>", to be exported as DISPLAY.
+    QString display_name() const;
+
+private:
+    void handle_connection();
+    void unwatch();
+    void release();
+
+    std::function<void(std::vector<int> const&)> start;
+    int display{-1};
+
+    int abstract_fd{-1};
+    int path_fd{-1};
+    std::unique_ptr<QSocketNotifier> abstract_notifier;
+    std::unique_ptr<QSocketNotifier> path_notifier;
+};
+
+}